@@ -0,0 +1,277 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+// Остальные библиотеки
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "Hash.h"            // Хеширование
+#include "Mesh.h"            // Класс меша
+#include "TextureStreamer.h" // Асинхронная загрузка текстур
+
+// Кеш ассетов с подсчетом ссылок
+// ------------------------------
+// Ассет ищется по ключу пути, а при промахе - по хешу содержимого (если
+// он задан), так что одинаковые файлы по разным путям загружаются один
+// раз. Когда счетчик ссылок падает до нуля, ассет не выгружается сразу, а
+// попадает в LRU-список; выгружаются самые давно неиспользуемые ассеты
+// сверх maxUnused.
+template <typename T> class AssetCache {
+public:
+  using Unload = std::function<void(T &)>;
+
+  // Максимальное число неиспользуемых ассетов, остающихся в памяти
+  std::size_t maxUnused;
+
+  AssetCache(std::size_t unusedLimit, Unload unloadFunc)
+      : maxUnused(unusedLimit), unload(std::move(unloadFunc)) {}
+
+  // Поиск по каноническому пути (увеличивает счетчик ссылок)
+  T *findByPath(const std::string &path) {
+    auto it = byPath.find(path);
+    return it == byPath.end() ? nullptr : acquire(*it->second);
+  }
+
+  // Поиск по хешу содержимого; путь запоминается как псевдоним
+  T *findByContent(std::uint64_t contentHash, const std::string &path) {
+    auto it = byContent.find(contentHash);
+    if (it == byContent.end())
+      return nullptr;
+    Entry &entry = *it->second;
+    entry.paths.push_back(path);
+    byPath[path] = &entry;
+    return acquire(entry);
+  }
+
+  // Добавление загруженного ассета (со счетчиком ссылок 1)
+  T *insert(const std::string &path, std::uint64_t contentHash,
+            std::unique_ptr<T> value) {
+    auto entry = std::make_unique<Entry>();
+    entry->value = std::move(value);
+    entry->contentHash = contentHash;
+    entry->paths.push_back(path);
+    entry->refs = 1;
+    entry->unused = unusedList.end();
+
+    Entry *ptr = entry.get();
+    byPath[path] = ptr;
+    if (contentHash)
+      byContent[contentHash] = ptr;
+    byValue[ptr->value.get()] = ptr;
+    entries.push_back(std::move(entry));
+    return ptr->value.get();
+  }
+
+  // Дополнительная ссылка на уже полученный ассет
+  void retain(const T *value) {
+    auto it = byValue.find(value);
+    if (it != byValue.end())
+      acquire(*it->second);
+  }
+
+  // Освобождение ссылки
+  void release(const T *value) {
+    auto it = byValue.find(value);
+    if (it == byValue.end())
+      return;
+    Entry &entry = *it->second;
+    if (--entry.refs > 0)
+      return;
+    entry.unused = unusedList.insert(unusedList.end(), &entry);
+    while (unusedList.size() > maxUnused)
+      evict(*unusedList.front());
+  }
+
+  // Выгрузка всех неиспользуемых ассетов
+  void collect() {
+    while (!unusedList.empty())
+      evict(*unusedList.front());
+  }
+
+  // Выгрузка всех ассетов, включая используемые
+  void clear() {
+    for (auto &entry : entries)
+      unload(*entry->value);
+    entries.clear();
+    unusedList.clear();
+    byPath.clear();
+    byContent.clear();
+    byValue.clear();
+  }
+
+  std::size_t size() const { return entries.size(); }
+  std::size_t unusedCount() const { return unusedList.size(); }
+
+private:
+  struct Entry {
+    std::unique_ptr<T> value;
+    std::uint32_t refs = 0;
+    std::uint64_t contentHash = 0;
+    std::vector<std::string> paths;
+    typename std::list<Entry *>::iterator unused;
+  };
+
+  Unload unload;
+  std::vector<std::unique_ptr<Entry>> entries;
+  std::list<Entry *> unusedList; // От давно к недавно освобожденным
+  std::unordered_map<std::string, Entry *> byPath;
+  std::unordered_map<std::uint64_t, Entry *> byContent;
+  std::unordered_map<const T *, Entry *> byValue;
+
+  T *acquire(Entry &entry) {
+    if (entry.refs++ == 0) {
+      unusedList.erase(entry.unused);
+      entry.unused = unusedList.end();
+    }
+    return entry.value.get();
+  }
+
+  void evict(Entry &entry) {
+    unusedList.erase(entry.unused);
+    for (const std::string &path : entry.paths)
+      byPath.erase(path);
+    auto content = byContent.find(entry.contentHash);
+    if (content != byContent.end() && content->second == &entry)
+      byContent.erase(content);
+    byValue.erase(entry.value.get());
+    unload(*entry.value);
+    std::erase_if(entries,
+                  [&entry](const auto &ptr) { return ptr.get() == &entry; });
+  }
+};
+
+// Ассеты
+// ------
+/* Текстура */
+struct TextureAsset {
+  unsigned int id;
+};
+
+/* Модель */
+struct ModelAsset {
+  std::vector<AnyMesh> meshes;
+  std::vector<const TextureAsset *> textures; // Ссылки на текстуры мешей
+  std::string path;
+  std::string directory;
+};
+
+// Реестр ассетов процесса
+// -----------------------
+// Все модели и текстуры загружаются через реестр, поэтому N экземпляров
+// одной сцены стоят одного импорта и одной загрузки в GPU
+class AssetRegistry {
+public:
+  AssetCache<TextureAsset> textures{
+      64, [](TextureAsset &texture) {
+        TextureStreamer::instance().unload(texture.id);
+      }};
+  AssetCache<ModelAsset> models{8, [this](ModelAsset &model) {
+                                  for (AnyMesh &mesh : model.meshes)
+                                    std::visit([](auto &m) { m.release(); },
+                                               mesh);
+                                  for (const TextureAsset *texture :
+                                       model.textures)
+                                    textures.release(texture);
+                                }};
+
+  // Глобальный экземпляр
+  static AssetRegistry &instance() {
+    static AssetRegistry registry;
+    return registry;
+  }
+
+  // Канонический путь (файл может еще не существовать)
+  static std::string canonicalPath(const std::string &path) {
+    std::error_code error;
+    std::filesystem::path canonical =
+        std::filesystem::weakly_canonical(path, error);
+    return error ? path : canonical.string();
+  }
+
+  // Получение текстуры. Один файл с разными gamma и role (sRGB и формат
+  // сжатия) - разные текстуры. Текстуры ищутся только по пути: хеширование
+  // содержимого прочитало бы файл на потоке контекста до асинхронной
+  // загрузки (TextureStreamer.h)
+  const TextureAsset *
+  acquireTexture(const std::string &path, bool gamma = false,
+                 TextureRole role = TextureRole::Color) {
+    std::string canonical = canonicalPath(path);
+    std::string key = canonical + '?' + std::to_string(gamma) + ':' +
+                      std::to_string(static_cast<int>(role));
+    if (TextureAsset *texture = textures.findByPath(key))
+      return texture;
+
+    auto texture = std::make_unique<TextureAsset>();
+    texture->id = TextureStreamer::instance().load(canonical, gamma, role);
+    return textures.insert(key, 0, std::move(texture));
+  }
+
+  // Освобождение текстуры
+  void release(const TextureAsset *texture) {
+    if (!shutDown)
+      textures.release(texture);
+  }
+
+  // Получение модели. Если модели нет в реестре, load(asset, contentHash)
+  // загружает ее. Модели одного файла с разными options (опциями импорта)
+  // или gamma (текстуры в sRGB) хранятся отдельно. Одинаковые файлы
+  // совпадают по содержимому, только если лежат в одном каталоге:
+  // материалы и текстуры ищутся рядом с файлом модели
+  const ModelAsset *
+  acquireModel(const std::string &path, std::uint32_t options, bool gamma,
+               const std::function<void(ModelAsset &, std::uint64_t)> &load) {
+    std::string canonical = canonicalPath(path);
+    std::string key = canonical + '?' + std::to_string(options) + ':' +
+                      std::to_string(gamma);
+    if (ModelAsset *model = models.findByPath(key))
+      return model;
+    std::uint64_t contentHash = hashFile(canonical);
+    std::string directory =
+        std::filesystem::path(canonical).parent_path().string();
+    std::uint64_t variantHash =
+        contentHash ? hashString(directory,
+                                 hashValue(gamma, hashValue(options,
+                                                            contentHash)))
+                    : 0;
+    if (variantHash)
+      if (ModelAsset *model = models.findByContent(variantHash, key))
+        return model;
+
+    auto model = std::make_unique<ModelAsset>();
+    load(*model, contentHash);
+    return models.insert(key, variantHash, std::move(model));
+  }
+
+  // Дополнительная ссылка на модель
+  void retain(const ModelAsset *model) { models.retain(model); }
+
+  // Освобождение модели
+  void release(const ModelAsset *model) {
+    if (!shutDown)
+      models.release(model);
+  }
+
+  // Выгрузка всех ассетов (до уничтожения контекста). Ссылки, освобожденные
+  // после этого, игнорируются
+  void shutdown() {
+    models.clear();
+    textures.clear();
+    shutDown = true;
+  }
+
+private:
+  bool shutDown = false;
+
+  AssetRegistry() = default;
+};
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+// Остальные библиотеки
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Блочное сжатие текстур (BC1/BC3/BC4/BC5)
+// ----------------------------------------
+// Кодировщики работают с изображениями RGBA8 и блоками 4x4 пикселя.
+// Декодеры повторяют аппаратное декодирование и нужны для проверки качества
+// сжатия без GPU (см. psnr()).
+namespace BlockCompression {
+
+// Формат сжатых данных
+enum class Format { BC1, BC3, BC4, BC5 };
+
+// Размер блока в байтах
+constexpr std::size_t blockSize(Format format) {
+  return format == Format::BC1 || format == Format::BC4 ? 8 : 16;
+}
+
+// Размер сжатого уровня в байтах
+constexpr std::size_t levelSize(Format format, int width, int height) {
+  return static_cast<std::size_t>((width + 3) / 4) *
+         static_cast<std::size_t>((height + 3) / 4) * blockSize(format);
+}
+
+// Изображение RGBA8
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<std::uint8_t> pixels; // width * height * 4
+};
+
+// Уменьшение изображения вдвое (усреднение 2x2). Для sRGB изображений цвет
+// усредняется в линейном пространстве, как в glGenerateTextureMipmap
+inline Image downsample(const Image &src, bool srgb = false) {
+  static const auto toLinear = [] {
+    std::array<float, 256> table;
+    for (int i = 0; i < 256; i++) {
+      float value = float(i) / 255.f;
+      table[std::size_t(i)] =
+          value <= 0.04045f ? value / 12.92f
+                            : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+    return table;
+  }();
+  auto toSrgb = [](float value) {
+    value = value <= 0.0031308f
+                ? value * 12.92f
+                : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+    return static_cast<std::uint8_t>(
+        std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+  };
+
+  Image dst;
+  dst.width = std::max(1, src.width / 2);
+  dst.height = std::max(1, src.height / 2);
+  dst.pixels.resize(static_cast<std::size_t>(dst.width) *
+                    static_cast<std::size_t>(dst.height) * 4);
+  for (int y = 0; y < dst.height; y++) {
+    int y0 = std::min(y * 2, src.height - 1);
+    int y1 = std::min(y * 2 + 1, src.height - 1);
+    for (int x = 0; x < dst.width; x++) {
+      int x0 = std::min(x * 2, src.width - 1);
+      int x1 = std::min(x * 2 + 1, src.width - 1);
+      for (int c = 0; c < 4; c++) {
+        auto at = [&src, c](int px, int py) {
+          return src.pixels[(static_cast<std::size_t>(py) *
+                                 static_cast<std::size_t>(src.width) +
+                             static_cast<std::size_t>(px)) *
+                                4 +
+                            static_cast<std::size_t>(c)];
+        };
+        std::uint8_t &out =
+            dst.pixels[(static_cast<std::size_t>(y) *
+                            static_cast<std::size_t>(dst.width) +
+                        static_cast<std::size_t>(x)) *
+                           4 +
+                       static_cast<std::size_t>(c)];
+        if (srgb && c < 3) {
+          out = toSrgb((toLinear[at(x0, y0)] + toLinear[at(x1, y0)] +
+                        toLinear[at(x0, y1)] + toLinear[at(x1, y1)]) /
+                       4.f);
+        } else {
+          int sum = at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1);
+          out = static_cast<std::uint8_t>((sum + 2) / 4);
+        }
+      }
+    }
+  }
+  return dst;
+}
+
+// Полная цепочка mip-уровней (уровень 0 - исходное изображение)
+inline std::vector<Image> buildMipChain(Image base, bool srgb = false) {
+  std::vector<Image> chain;
+  chain.push_back(std::move(base));
+  while (chain.back().width > 1 || chain.back().height > 1)
+    chain.push_back(downsample(chain.back(), srgb));
+  return chain;
+}
+
+namespace detail {
+
+// Блок 4x4 пикселя (края изображения повторяются)
+inline void fetchBlock(const Image &image, int bx, int by,
+                       std::uint8_t block[16][4]) {
+  for (int y = 0; y < 4; y++)
+    for (int x = 0; x < 4; x++) {
+      int px = std::min(bx * 4 + x, image.width - 1);
+      int py = std::min(by * 4 + y, image.height - 1);
+      std::memcpy(block[y * 4 + x],
+                  &image.pixels[(static_cast<std::size_t>(py) *
+                                     static_cast<std::size_t>(image.width) +
+                                 static_cast<std::size_t>(px)) *
+                                4],
+                  4);
+    }
+}
+
+inline void putBlock(Image &image, int bx, int by,
+                     const std::uint8_t block[16][4]) {
+  for (int y = 0; y < 4; y++)
+    for (int x = 0; x < 4; x++) {
+      int px = bx * 4 + x;
+      int py = by * 4 + y;
+      if (px < image.width && py < image.height)
+        std::memcpy(&image.pixels[(static_cast<std::size_t>(py) *
+                                       static_cast<std::size_t>(image.width) +
+                                   static_cast<std::size_t>(px)) *
+                                  4],
+                    block[y * 4 + x], 4);
+    }
+}
+
+inline void write16(std::uint8_t *out, std::uint16_t value) {
+  out[0] = static_cast<std::uint8_t>(value & 0xFF);
+  out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+inline std::uint16_t read16(const std::uint8_t *in) {
+  return static_cast<std::uint16_t>(in[0] | (in[1] << 8));
+}
+
+// Цвет RGB565
+inline std::uint16_t packRGB565(const float color[3]) {
+  auto q = [](float value, int max) {
+    return static_cast<int>(
+        std::lround(std::clamp(value, 0.f, 255.f) * float(max) / 255.f));
+  };
+  return static_cast<std::uint16_t>((q(color[0], 31) << 11) |
+                                    (q(color[1], 63) << 5) | q(color[2], 31));
+}
+
+inline void unpackRGB565(std::uint16_t packed, int color[3]) {
+  int r = (packed >> 11) & 31;
+  int g = (packed >> 5) & 63;
+  int b = packed & 31;
+  color[0] = (r << 3) | (r >> 2);
+  color[1] = (g << 2) | (g >> 4);
+  color[2] = (b << 3) | (b >> 2);
+}
+
+// Палитра BC1 (4 цвета, если c0 > c1, иначе 3 цвета и черный)
+inline void paletteBC1(std::uint16_t c0, std::uint16_t c1, int palette[4][3]) {
+  unpackRGB565(c0, palette[0]);
+  unpackRGB565(c1, palette[1]);
+  for (int c = 0; c < 3; c++) {
+    if (c0 > c1) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    } else {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      palette[3][c] = 0;
+    }
+  }
+}
+
+// Палитра BC4 (режим 8 значений при a0 > a1)
+inline void paletteBC4(std::uint8_t a0, std::uint8_t a1, int palette[8]) {
+  palette[0] = a0;
+  palette[1] = a1;
+  if (a0 > a1) {
+    for (int i = 1; i < 7; i++)
+      palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+  } else {
+    for (int i = 1; i < 5; i++)
+      palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+// Кодирование цветового блока BC1 (всегда режим 4 цветов)
+// Конечные точки - крайние проекции пикселей на главную ось цветов блока
+inline void encodeColorBlock(const std::uint8_t block[16][4],
+                             std::uint8_t *out) {
+  float mean[3] = {};
+  for (int i = 0; i < 16; i++)
+    for (int c = 0; c < 3; c++)
+      mean[c] += block[i][c] / 16.f;
+
+  // Ковариация и главная ось (степенной метод)
+  float cov[6] = {};
+  for (int i = 0; i < 16; i++) {
+    float d[3] = {block[i][0] - mean[0], block[i][1] - mean[1],
+                  block[i][2] - mean[2]};
+    cov[0] += d[0] * d[0];
+    cov[1] += d[0] * d[1];
+    cov[2] += d[0] * d[2];
+    cov[3] += d[1] * d[1];
+    cov[4] += d[1] * d[2];
+    cov[5] += d[2] * d[2];
+  }
+  float axis[3] = {1.f, 1.f, 1.f};
+  for (int iteration = 0; iteration < 8; iteration++) {
+    float next[3] = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                     cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                     cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+    float length = std::sqrt(next[0] * next[0] + next[1] * next[1] +
+                             next[2] * next[2]);
+    if (length < 1e-6f)
+      break;
+    for (int c = 0; c < 3; c++)
+      axis[c] = next[c] / length;
+  }
+
+  float minProj = 1e9f, maxProj = -1e9f;
+  for (int i = 0; i < 16; i++) {
+    float proj = (block[i][0] - mean[0]) * axis[0] +
+                 (block[i][1] - mean[1]) * axis[1] +
+                 (block[i][2] - mean[2]) * axis[2];
+    minProj = std::min(minProj, proj);
+    maxProj = std::max(maxProj, proj);
+  }
+  float maxColor[3], minColor[3];
+  for (int c = 0; c < 3; c++) {
+    maxColor[c] = mean[c] + axis[c] * maxProj;
+    minColor[c] = mean[c] + axis[c] * minProj;
+  }
+
+  std::uint16_t c0 = packRGB565(maxColor);
+  std::uint16_t c1 = packRGB565(minColor);
+  if (c0 < c1)
+    std::swap(c0, c1);
+
+  std::uint32_t indices = 0;
+  if (c0 != c1) {
+    int palette[4][3];
+    paletteBC1(c0, c1, palette);
+    for (int i = 0; i < 16; i++) {
+      int best = 0, bestError = 1 << 30;
+      for (int p = 0; p < 4; p++) {
+        int error = 0;
+        for (int c = 0; c < 3; c++) {
+          int d = block[i][c] - palette[p][c];
+          error += d * d;
+        }
+        if (error < bestError) {
+          bestError = error;
+          best = p;
+        }
+      }
+      indices |= static_cast<std::uint32_t>(best) << (i * 2);
+    }
+  }
+
+  write16(out, c0);
+  write16(out + 2, c1);
+  for (int i = 0; i < 4; i++)
+    out[4 + i] = static_cast<std::uint8_t>(indices >> (i * 8));
+}
+
+// Кодирование одноканального блока BC4 (канал channel пикселей блока)
+inline void encodeChannelBlock(const std::uint8_t block[16][4], int channel,
+                               std::uint8_t *out) {
+  std::uint8_t a0 = 0, a1 = 255;
+  for (int i = 0; i < 16; i++) {
+    a0 = std::max(a0, block[i][channel]);
+    a1 = std::min(a1, block[i][channel]);
+  }
+
+  std::uint64_t indices = 0;
+  if (a0 != a1) {
+    int palette[8];
+    paletteBC4(a0, a1, palette);
+    for (int i = 0; i < 16; i++) {
+      int best = 0, bestError = 1 << 30;
+      for (int p = 0; p < 8; p++) {
+        int error = std::abs(block[i][channel] - palette[p]);
+        if (error < bestError) {
+          bestError = error;
+          best = p;
+        }
+      }
+      indices |= static_cast<std::uint64_t>(best) << (i * 3);
+    }
+  }
+
+  out[0] = a0;
+  out[1] = a1;
+  for (int i = 0; i < 6; i++)
+    out[2 + i] = static_cast<std::uint8_t>(indices >> (i * 8));
+}
+
+inline void decodeColorBlock(const std::uint8_t *in,
+                             std::uint8_t block[16][4]) {
+  int palette[4][3];
+  std::uint16_t c0 = read16(in), c1 = read16(in + 2);
+  paletteBC1(c0, c1, palette);
+  for (int i = 0; i < 16; i++) {
+    int index = (in[4 + i / 4] >> ((i % 4) * 2)) & 3;
+    for (int c = 0; c < 3; c++)
+      block[i][c] = static_cast<std::uint8_t>(palette[index][c]);
+    block[i][3] = (c0 <= c1 && index == 3) ? 0 : 255;
+  }
+}
+
+inline void decodeChannelBlock(const std::uint8_t *in, int channel,
+                               std::uint8_t block[16][4]) {
+  int palette[8];
+  paletteBC4(in[0], in[1], palette);
+  std::uint64_t indices = 0;
+  for (int i = 0; i < 6; i++)
+    indices |= static_cast<std::uint64_t>(in[2 + i]) << (i * 8);
+  for (int i = 0; i < 16; i++)
+    block[i][channel] =
+        static_cast<std::uint8_t>(palette[(indices >> (i * 3)) & 7]);
+}
+
+} // namespace detail
+
+// Сжатие уровня
+// -------------
+// BC1 - RGB, BC3 - RGB + альфа, BC4 - канал R, BC5 - каналы R и G
+inline std::vector<std::uint8_t> encode(const Image &image, Format format) {
+  int blocksX = (image.width + 3) / 4;
+  int blocksY = (image.height + 3) / 4;
+  std::vector<std::uint8_t> data(levelSize(format, image.width, image.height));
+  std::uint8_t *out = data.data();
+  std::uint8_t block[16][4];
+  for (int by = 0; by < blocksY; by++)
+    for (int bx = 0; bx < blocksX; bx++) {
+      detail::fetchBlock(image, bx, by, block);
+      switch (format) {
+      case Format::BC1:
+        detail::encodeColorBlock(block, out);
+        break;
+      case Format::BC3:
+        detail::encodeChannelBlock(block, 3, out);
+        detail::encodeColorBlock(block, out + 8);
+        break;
+      case Format::BC4:
+        detail::encodeChannelBlock(block, 0, out);
+        break;
+      case Format::BC5:
+        detail::encodeChannelBlock(block, 0, out);
+        detail::encodeChannelBlock(block, 1, out + 8);
+        break;
+      }
+      out += blockSize(format);
+    }
+  return data;
+}
+
+// Распаковка уровня в RGBA8
+// -------------------------
+// Отсутствующие в формате каналы заполняются как при выборке в шейдере
+// (0 для цвета, 255 для альфы)
+inline Image decode(const std::uint8_t *data, int width, int height,
+                    Format format) {
+  Image image;
+  image.width = width;
+  image.height = height;
+  image.pixels.resize(static_cast<std::size_t>(width) *
+                      static_cast<std::size_t>(height) * 4);
+  int blocksX = (width + 3) / 4;
+  int blocksY = (height + 3) / 4;
+  std::uint8_t block[16][4];
+  for (int by = 0; by < blocksY; by++)
+    for (int bx = 0; bx < blocksX; bx++) {
+      for (auto &pixel : block) {
+        pixel[0] = pixel[1] = pixel[2] = 0;
+        pixel[3] = 255;
+      }
+      switch (format) {
+      case Format::BC1:
+        detail::decodeColorBlock(data, block);
+        break;
+      case Format::BC3:
+        detail::decodeColorBlock(data + 8, block);
+        detail::decodeChannelBlock(data, 3, block);
+        break;
+      case Format::BC4:
+        detail::decodeChannelBlock(data, 0, block);
+        break;
+      case Format::BC5:
+        detail::decodeChannelBlock(data, 0, block);
+        detail::decodeChannelBlock(data + 8, 1, block);
+        break;
+      }
+      detail::putBlock(image, bx, by, block);
+      data += blockSize(format);
+    }
+  return image;
+}
+
+// Пиковое отношение сигнал/шум (дБ) по каналам, которые хранит формат
+inline double psnr(const Image &source, const Image &decoded, Format format) {
+  int channels[4] = {};
+  int channelCount = 0;
+  switch (format) {
+  case Format::BC1:
+    channelCount = 3;
+    channels[0] = 0, channels[1] = 1, channels[2] = 2;
+    break;
+  case Format::BC3:
+    channelCount = 4;
+    channels[0] = 0, channels[1] = 1, channels[2] = 2, channels[3] = 3;
+    break;
+  case Format::BC4:
+    channelCount = 1;
+    break;
+  case Format::BC5:
+    channelCount = 2;
+    channels[1] = 1;
+    break;
+  }
+
+  double error = 0.0;
+  std::size_t pixelCount = static_cast<std::size_t>(source.width) *
+                           static_cast<std::size_t>(source.height);
+  for (std::size_t i = 0; i < pixelCount; i++)
+    for (int c = 0; c < channelCount; c++) {
+      double d = double(source.pixels[i * 4 + std::size_t(channels[c])]) -
+                 double(decoded.pixels[i * 4 + std::size_t(channels[c])]);
+      error += d * d;
+    }
+  error /= double(pixelCount * std::size_t(channelCount));
+  return error == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / error);
+}
+
+} // namespace BlockCompression
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+// GLAD
+#include "glad/gl.h"
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Остальные заголовочные файлы
+#include "GLState.h" // Кеш состояния OpenGL
+#include "Shader.h"  // Класс шейдера
+
+// Точки привязки SSBO кластеров (см. clusterComputeShader.glsl)
+constexpr GLuint CLUSTER_GRID_BINDING = 5;
+constexpr GLuint CLUSTER_INDEX_BINDING = 6;
+
+// Параметры сетки кластеров (std430, начало буфера сетки)
+struct ClusterHeader {
+  glm::uvec4 size;  // xyz - число кластеров, w - максимум источников
+  glm::vec4 depth;  // x - near, y - far, z/w - масштаб и смещение среза
+  glm::vec4 screen; // xy - размер экрана в пикселях
+  glm::mat4 inverseProjection;
+};
+
+static_assert(sizeof(ClusterHeader) == 112);
+
+// Кластерное освещение
+// --------------------
+// Пирамида видимости делится на сетку CLUSTERS_X x CLUSTERS_Y тайлов
+// экрана и CLUSTERS_Z срезов по глубине (экспоненциально от near к far).
+// Каждый кадр вычислительный шейдер проверяет точечные источники
+// (POINT_LIGHT_BINDING, сфера радиуса range) на пересечение с AABB
+// кластеров в пространстве вида и записывает индексы попавших источников
+// в участок кластера (до MAX_LIGHTS_PER_CLUSTER). Фрагментный шейдер
+// находит свой кластер по gl_FragCoord и глубине и перебирает только его
+// источники.
+class ClusteredLighting {
+public:
+  static constexpr unsigned int CLUSTERS_X = 16;
+  static constexpr unsigned int CLUSTERS_Y = 9;
+  static constexpr unsigned int CLUSTERS_Z = 24;
+  static constexpr unsigned int CLUSTER_COUNT =
+      CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+  static constexpr unsigned int MAX_LIGHTS_PER_CLUSTER = 256;
+
+  explicit ClusteredLighting(const char *computePath)
+      : cullShader(computePath) {}
+
+  // Распределение источников по кластерам. Буфер точечных источников
+  // должен быть привязан (LightManager::upload)
+  void update(const glm::mat4 &projection, float zNear, float zFar,
+              glm::vec2 screenSize) {
+    if (!gridBuffer) {
+      glCreateBuffers(1, &gridBuffer);
+      glNamedBufferStorage(
+          gridBuffer,
+          sizeof(ClusterHeader) + CLUSTER_COUNT * sizeof(std::uint32_t),
+          nullptr, GL_DYNAMIC_STORAGE_BIT);
+      glCreateBuffers(1, &indexBuffer);
+      glNamedBufferStorage(indexBuffer,
+                           std::size_t(CLUSTER_COUNT) *
+                               MAX_LIGHTS_PER_CLUSTER * sizeof(std::uint32_t),
+                           nullptr, 0);
+      uploaded = false;
+    }
+
+    // Параметры сетки загружаются только при изменении проекции
+    float logRatio = std::log(zFar / zNear);
+    ClusterHeader header = {
+        glm::uvec4(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z,
+                   MAX_LIGHTS_PER_CLUSTER),
+        glm::vec4(zNear, zFar, float(CLUSTERS_Z) / logRatio,
+                  -float(CLUSTERS_Z) * std::log(zNear) / logRatio),
+        glm::vec4(screenSize.x, screenSize.y, 0.f, 0.f),
+        glm::inverse(projection)};
+    if (!uploaded || std::memcmp(&header, &current, sizeof(header)) != 0) {
+      glNamedBufferSubData(gridBuffer, 0, sizeof(header), &header);
+      current = header;
+      uploaded = true;
+    }
+
+    GLState &state = GLState::instance();
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_GRID_BINDING,
+                         gridBuffer);
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDEX_BINDING,
+                         indexBuffer);
+    cullShader.use();
+    glDispatchCompute(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z);
+    // Списки читаются фрагментным шейдером
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  // Удаление буферов и программы (до уничтожения контекста)
+  void release() {
+    GLState::instance().deleteBuffers(1, &gridBuffer);
+    GLState::instance().deleteBuffers(1, &indexBuffer);
+    gridBuffer = indexBuffer = 0;
+    cullShader.deleteProgram();
+  }
+
+private:
+  Shader cullShader;
+  unsigned int gridBuffer = 0, indexBuffer = 0;
+  ClusterHeader current = {};
+  bool uploaded = false;
+};
+
+#endif
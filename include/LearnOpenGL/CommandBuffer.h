@@ -0,0 +1,274 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "GeometryHeap.h" // Куча геометрии
+#include "IndirectDraw.h" // Непрямая отрисовка
+#include "Mesh.h"         // Класс меша
+#include "Shader.h"       // Класс шейдера
+
+// Проходы очереди (старшие биты ключа: проходы не перемешиваются)
+enum RenderPass : std::uint32_t {
+  PASS_DEPTH = 0,  // Предварительный проход глубины
+  PASS_OPAQUE = 1, // Непрозрачная геометрия
+  PASS_COUNT = 4
+};
+
+// Команда отрисовки: состояние и готовые записи для буферов GL
+// (indirect.baseInstance - индекс параметров материала, data.transform -
+// индекс в трансформациях своего буфера, см. IndirectDraw.h)
+struct DrawCommand {
+  std::uint64_t key;
+  Shader *shader;
+  const MaterialBinding *material; // nullptr - без текстур (только глубина)
+  unsigned int vao;
+  DrawElementsIndirectCommand indirect;
+  IndirectDrawData data;
+};
+
+static_assert(std::is_trivially_copyable_v<DrawCommand>);
+
+// Вид: камера, для которой записываются команды
+// ----------------------------------------------
+// Плоскости пирамиды видимости извлекаются из матрицы projection * view
+// (нормали направлены внутрь), глубина ключа - расстояние вдоль
+// направления камеры, отнесенное к дальней плоскости.
+struct RenderView {
+  glm::vec3 eye = glm::vec3(0.f);
+  glm::vec3 forward = glm::vec3(0.f, 0.f, -1.f);
+  float farPlane = 1.f;
+  std::array<glm::vec4, 6> planes = {};
+
+  RenderView() = default;
+  RenderView(const glm::mat4 &viewProj, const glm::vec3 &cameraEye,
+             const glm::vec3 &cameraForward, float cameraFar)
+      : eye(cameraEye), forward(cameraForward), farPlane(cameraFar) {
+    // Строки матрицы (GLM хранит столбцы)
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+      rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i],
+                          viewProj[3][i]);
+    for (int i = 0; i < 3; i++) {
+      planes[i * 2] = rows[3] + rows[i];
+      planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+    for (glm::vec4 &plane : planes)
+      plane = plane / glm::length(glm::vec3(plane));
+  }
+
+  // Пересекает ли сфера пирамиду видимости
+  bool visible(const glm::vec3 &center, float radius) const {
+    for (const glm::vec4 &plane : planes)
+      if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        return false;
+    return true;
+  }
+};
+
+// Буфер команд
+// ------------
+// Записывается одним потоком без блокировок и без вызовов GL: отсечение
+// по пирамиде видимости, расчет матриц нормали, ключей и сортировка
+// выполняются на рабочем потоке, поток контекста только воспроизводит
+// готовые команды (см. RenderQueue.h). Во время записи куча геометрии и
+// таблица материалов только читаются: они меняются на потоке контекста,
+// который ждет окончания записи.
+//
+// Команды и трансформации хранятся в формате SSBO непрямой отрисовки
+// (IndirectDraw.h), поэтому при воспроизведении они только копируются и
+// загружаются одним вызовом на буфер GL.
+//
+// Поля ключа (от старших битов):
+//   непрозрачный проход: проход | программа | набор текстур | VAO | глубина
+//   проход глубины:      проход | глубина | программа | VAO
+// Программа и VAO - имена объектов GL, набор текстур - номер из таблицы
+// материалов (MaterialBinding::textureSet); значения сверх разрядности
+// поля делят последний номер (порядок верен, лишь группы сливаются).
+// Одинаковое состояние идет подряд и переключается один раз на группу;
+// внутри группы (а в проходе глубины - везде) меши рисуются от ближних к
+// дальним, и тест глубины отбрасывает закрытые фрагменты до фрагментного
+// шейдера.
+class CommandBuffer {
+public:
+  // Разрядность полей ключа
+  static constexpr unsigned int PASS_BITS = 2;
+  static constexpr unsigned int PROGRAM_BITS = 10;
+  static constexpr unsigned int MATERIAL_BITS = 14;
+  static constexpr unsigned int VAO_BITS = 10;
+  static constexpr unsigned int DEPTH_BITS = 28;
+  static_assert(PASS_BITS + PROGRAM_BITS + MATERIAL_BITS + VAO_BITS +
+                    DEPTH_BITS ==
+                64);
+  static_assert(PASS_COUNT <= (1u << PASS_BITS));
+
+  // Элемент порядка: ключ и индекс команды
+  struct SortEntry {
+    std::uint64_t key;
+    std::uint32_t index;
+  };
+
+  // Очистка буфера перед записью кадра для вида target (память сохраняется)
+  void clear(const RenderView &target) {
+    view = target;
+    depthScale = view.farPlane > 0.f ? 1.f / view.farPlane : 0.f;
+    transforms.clear();
+    commands.clear();
+    order.clear();
+    culledCount = 0;
+  }
+
+  // Добавление трансформации, возвращает ее индекс
+  std::uint32_t addTransform(const glm::mat4 &model) {
+    transforms.push_back({model, glm::transpose(glm::inverse(model))});
+    return static_cast<std::uint32_t>(transforms.size() - 1);
+  }
+
+  // Запись меша с трансформацией transform в проход pass (меш вне
+  // пирамиды видимости отбрасывается)
+  template <typename VertexT>
+  void add(RenderPass pass, Shader &shader, const Mesh<VertexT> &mesh,
+           std::uint32_t transform) {
+    GeometryRange range = GeometryHeap::instance().range(mesh.geometry);
+    bool depthOnly = pass == PASS_DEPTH;
+    unsigned int vao = depthOnly ? range.depthVAO : range.vao;
+    if (!vao || range.indexCount <= 0)
+      return;
+
+    // Ограничивающая сфера меша (позиции квантованы в [0, 1], см.
+    // VertexPacking.h); радиус растягивается наибольшим масштабом модели
+    const glm::mat4 &model = transforms[transform].model;
+    const VertexQuantization &q = mesh.quantization;
+    glm::vec3 center =
+        glm::vec3(model * glm::vec4(q.offset + q.scale * 0.5f, 1.f));
+    float scale = std::max({glm::dot(model[0], model[0]),
+                            glm::dot(model[1], model[1]),
+                            glm::dot(model[2], model[2])});
+    float radius = glm::length(q.scale) * 0.5f * std::sqrt(scale);
+    if (!view.visible(center, radius)) {
+      culledCount++;
+      return;
+    }
+
+    const MaterialBinding *material = depthOnly ? nullptr : &mesh.material;
+    std::uint64_t depth = quantizeDepth(center);
+    std::uint64_t program = field(shader.ID, PROGRAM_BITS);
+    std::uint64_t vaoId = field(vao, VAO_BITS);
+    std::uint64_t key = std::uint64_t(pass) << (64 - PASS_BITS);
+    if (depthOnly) {
+      key |= depth << (64 - PASS_BITS - DEPTH_BITS);
+      key |= program << VAO_BITS;
+      key |= vaoId;
+    } else {
+      key |= program << (64 - PASS_BITS - PROGRAM_BITS);
+      key |= field(material->textureSet, MATERIAL_BITS)
+             << (DEPTH_BITS + VAO_BITS);
+      key |= vaoId << DEPTH_BITS;
+      key |= depth;
+    }
+    DrawElementsIndirectCommand indirect = {
+        static_cast<std::uint32_t>(range.indexCount), 1, range.firstIndex,
+        range.baseVertex, material ? material->index : 0};
+    IndirectDrawData data = {{q.offset.x, q.offset.y, q.offset.z},
+                             transform,
+                             {q.scale.x, q.scale.y, q.scale.z},
+                             0};
+    commands.push_back({key, &shader, material, vao, indirect, data});
+  }
+
+  // Сортировка команд по ключу (после записи, на том же потоке).
+  // Поразрядная сортировка от младшего байта к старшему устойчива; байт,
+  // одинаковый у всех команд, пропускается
+  void sort() {
+    std::size_t count = commands.size();
+    order.resize(count);
+    scratch.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+      order[i] = {commands[i].key, static_cast<std::uint32_t>(i)};
+    if (count < 2)
+      return;
+
+    // Гистограммы всех восьми байтов ключа за один проход
+    std::array<std::array<std::uint32_t, 256>, 8> histograms = {};
+    for (const SortEntry &entry : order)
+      for (unsigned int digit = 0; digit < 8; digit++)
+        histograms[digit][(entry.key >> (digit * 8)) & 0xFF]++;
+
+    for (unsigned int digit = 0; digit < 8; digit++) {
+      std::array<std::uint32_t, 256> &histogram = histograms[digit];
+      unsigned int shift = digit * 8;
+      if (histogram[(order[0].key >> shift) & 0xFF] == count)
+        continue;
+      std::uint32_t offset = 0;
+      for (std::uint32_t &bucket : histogram)
+        offset += std::exchange(bucket, offset);
+      for (const SortEntry &entry : order)
+        scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+      order.swap(scratch);
+    }
+  }
+
+  // Отсортированный порядок команд прохода pass: [first, last)
+  std::pair<const SortEntry *, const SortEntry *>
+  passRange(RenderPass pass) const {
+    auto passOf = [](const SortEntry &entry) {
+      return static_cast<RenderPass>(entry.key >> (64 - PASS_BITS));
+    };
+    auto first = std::partition_point(
+        order.begin(), order.end(),
+        [&](const SortEntry &entry) { return passOf(entry) < pass; });
+    auto last = std::partition_point(
+        first, order.end(),
+        [&](const SortEntry &entry) { return passOf(entry) == pass; });
+    return {order.data() + (first - order.begin()),
+            order.data() + (last - order.begin())};
+  }
+
+  const DrawCommand &command(std::uint32_t index) const {
+    return commands[index];
+  }
+  // Трансформации буфера (std430, индексы - DrawCommand::data.transform)
+  const std::vector<IndirectTransform> &transformData() const {
+    return transforms;
+  }
+
+  // Число записанных и отброшенных отсечением команд
+  std::size_t size() const { return commands.size(); }
+  std::size_t culled() const { return culledCount; }
+
+private:
+  RenderView view;
+  float depthScale = 0.f;
+  std::vector<IndirectTransform> transforms;
+  std::vector<DrawCommand> commands;
+  std::vector<SortEntry> order, scratch;
+  std::size_t culledCount = 0;
+
+  // Значение поля ключа (ограничено разрядностью)
+  static std::uint64_t field(std::uint64_t value, unsigned int bits) {
+    return std::min<std::uint64_t>(value, (std::uint64_t(1) << bits) - 1);
+  }
+
+  // Квантованное расстояние точки вдоль направления камеры
+  // (0 - у камеры, максимум - дальняя плоскость и дальше)
+  std::uint64_t quantizeDepth(const glm::vec3 &point) const {
+    float depth = glm::dot(point - view.eye, view.forward) * depthScale;
+    depth = std::clamp(depth, 0.f, 1.f);
+    constexpr double maxDepth = double((std::uint64_t(1) << DEPTH_BITS) - 1);
+    return static_cast<std::uint64_t>(double(depth) * maxDepth);
+  }
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+// GLAD
+#include "glad/gl.h"
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <cstddef>
+#include <cstring>
+
+// Остальные заголовочные файлы
+#include "GLState.h" // Кеш состояния OpenGL
+
+// Точка привязки блока FrameData (см. шейдеры)
+constexpr GLuint FRAME_DATA_BINDING = 0;
+
+// Данные кадра (std140)
+// ---------------------
+// Объявление блока в шейдерах:
+//   layout (std140, binding = 0) uniform FrameData {
+//     mat4 view; mat4 projection; mat4 viewProj; vec4 cameraPos; vec4 time;
+//   };
+struct FrameData {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::mat4 viewProj;  // projection * view
+  glm::vec4 cameraPos; // xyz - позиция камеры
+  glm::vec4 time;      // x - игровое время, y - время кадра
+};
+
+static_assert(sizeof(FrameData) == 224 && offsetof(FrameData, cameraPos) == 192,
+              "FrameData must match the std140 layout");
+
+// Кольцо данных кадра
+// -------------------
+// FrameData пишется один раз за кадр в постоянно отображенный буфер из
+// FRAMES участков и привязывается к FRAME_DATA_BINDING, поэтому его видят
+// все программы, объявившие блок. Участок переиспользуется через FRAMES
+// кадров; перед записью поток ждет fence кадра, который его читал.
+class FrameUniforms {
+public:
+  static constexpr unsigned int FRAMES = 3;
+
+  // Создание буфера (требует текущий контекст OpenGL)
+  void init() {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride = (sizeof(FrameData) + std::size_t(alignment) - 1) /
+             std::size_t(alignment) * std::size_t(alignment);
+
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(stride * FRAMES),
+                         nullptr, flags);
+    memory = static_cast<unsigned char *>(glMapNamedBufferRange(
+        buffer, 0, static_cast<GLsizeiptr>(stride * FRAMES), flags));
+  }
+
+  // Запись и привязка данных нового кадра. Команды предыдущего кадра к
+  // этому моменту выданы, поэтому здесь же ставится его fence
+  void update(const FrameData &data) {
+    if (!memory)
+      return;
+    if (started)
+      fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    started = true;
+    frame = (frame + 1) % FRAMES;
+
+    // Ожидание GPU, если участок еще читается
+    if (fences[frame]) {
+      GLbitfield waitFlags = 0;
+      while (glClientWaitSync(fences[frame], waitFlags, 1000000) ==
+             GL_TIMEOUT_EXPIRED)
+        waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+      glDeleteSync(fences[frame]);
+      fences[frame] = nullptr;
+    }
+
+    std::memcpy(memory + stride * frame, &data, sizeof(FrameData));
+    GLState::instance().bindBufferRange(
+        GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, buffer,
+        static_cast<GLintptr>(stride * frame), sizeof(FrameData));
+  }
+
+  // Удаление буфера (до уничтожения контекста)
+  void release() {
+    for (GLsync &fence : fences)
+      if (fence) {
+        glDeleteSync(fence);
+        fence = nullptr;
+      }
+    if (buffer) {
+      glUnmapNamedBuffer(buffer);
+      GLState::instance().deleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    memory = nullptr;
+  }
+
+private:
+  unsigned int buffer = 0;
+  unsigned char *memory = nullptr;
+  std::size_t stride = 0;
+  unsigned int frame = 0;
+  bool started = false;
+  GLsync fences[FRAMES] = {};
+};
+
+#endif
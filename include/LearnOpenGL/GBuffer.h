@@ -0,0 +1,108 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные библиотеки
+#include <iostream>
+
+// Остальные заголовочные файлы
+#include "GLState.h" // Кеш состояния OpenGL
+
+// G-буфер
+// -------
+// Буфер кадра отложенного освещения (12 байт на пиксель):
+//   0 - GL_RGBA8: альбедо (rgb) и интенсивность блика (a);
+//   1 - GL_RGB10_A2: октаэдрическая нормаль (rg) и log2(shininess) / 10 (b);
+//   глубина - GL_DEPTH_COMPONENT32F, позиция восстанавливается по ней.
+// Текстуры привязываются к блокам 0-2 для прохода освещения
+// (deferredFragmentShader.glsl), который рисуется треугольником на весь
+// экран без вершинных атрибутов (пустой VAO). Проход переносит глубину
+// G-буфера в буфер кадра по умолчанию через gl_FragDepth (blit глубины
+// требует совпадения форматов), поэтому после него можно рисовать прямо.
+class GBuffer {
+public:
+  // Пересоздание вложений при изменении размера
+  void resize(GLsizei newWidth, GLsizei newHeight) {
+    if (framebuffer && width == newWidth && height == newHeight)
+      return;
+    destroyTargets();
+    width = newWidth;
+    height = newHeight;
+    if (!framebuffer) {
+      glCreateFramebuffers(1, &framebuffer);
+      glCreateVertexArrays(1, &emptyVAO);
+    }
+
+    auto createTarget = [&](GLenum format) {
+      unsigned int texture;
+      glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+      glTextureStorage2D(texture, 1, format, width, height);
+      glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      return texture;
+    };
+    albedoSpecular = createTarget(GL_RGBA8);
+    normal = createTarget(GL_RGB10_A2);
+    depth = createTarget(GL_DEPTH_COMPONENT32F);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0,
+                              albedoSpecular, 0);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, normal, 0);
+    glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT, depth, 0);
+    const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glNamedFramebufferDrawBuffers(framebuffer, 2, drawBuffers);
+
+    if (glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) !=
+        GL_FRAMEBUFFER_COMPLETE)
+      std::cout << "ERROR::GBUFFER::FRAMEBUFFER_INCOMPLETE" << std::endl;
+  }
+
+  // Начало прохода геометрии: запись в G-буфер
+  void bindForGeometry() const {
+    GLState::instance().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    const float zero[4] = {0.f, 0.f, 0.f, 0.f};
+    const float one = 1.f;
+    glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, zero);
+    glClearNamedFramebufferfv(framebuffer, GL_COLOR, 1, zero);
+    glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &one);
+  }
+
+  // Проход освещения в буфер кадра по умолчанию. Пиксели без геометрии
+  // отбрасываются шейдером, поэтому цвет очистки сохраняется
+  void drawLighting() const {
+    GLState &state = GLState::instance();
+    state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    state.bindTextureUnit(0, albedoSpecular);
+    state.bindTextureUnit(1, normal);
+    state.bindTextureUnit(2, depth);
+    state.depthFunc(GL_ALWAYS);
+    state.bindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    state.depthFunc(GL_LESS);
+  }
+
+  // Удаление ресурсов (до уничтожения контекста)
+  void release() {
+    destroyTargets();
+    GLState::instance().deleteFramebuffers(1, &framebuffer);
+    GLState::instance().deleteVertexArrays(1, &emptyVAO);
+    framebuffer = emptyVAO = 0;
+  }
+
+private:
+  unsigned int framebuffer = 0, emptyVAO = 0;
+  unsigned int albedoSpecular = 0, normal = 0, depth = 0;
+  GLsizei width = 0, height = 0;
+
+  void destroyTargets() {
+    GLState::instance().deleteTextures(1, &albedoSpecular);
+    GLState::instance().deleteTextures(1, &normal);
+    GLState::instance().deleteTextures(1, &depth);
+    albedoSpecular = normal = depth = 0;
+  }
+};
+
+#endif
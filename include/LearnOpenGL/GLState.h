@@ -0,0 +1,368 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+// Кеш состояния OpenGL
+// --------------------
+// Тонкий слой над вызовами GLAD: запоминает привязанные программу, VAO,
+// текстуры и сэмплеры блоков, буферы (общие и индексированные точки
+// привязки), буфер кадра и состояние глубины, смешивания, масок и режима
+// полигонов, и пропускает вызовы, которые ничего не меняют. Весь код
+// проекта меняет это состояние только через GLState; код вне проекта
+// (ImGui) - между вызовами invalidate(). Удаление объектов тоже идет через
+// GLState: имя удаленного объекта может быть выдано новому, и кеш не
+// должен считать его привязанным.
+//
+// Счетчики выполненных и пропущенных вызовов сбрасываются в endFrame().
+class GLState {
+public:
+  // Отслеживаемые текстурные блоки и индексированные точки привязки
+  static constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+  static constexpr unsigned int MAX_BUFFER_BINDINGS = 16;
+
+  // Глобальный экземпляр
+  static GLState &instance() {
+    static GLState state;
+    return state;
+  }
+
+  // Программа и VAO
+  // ------------------------------------------------------------------------
+  void useProgram(GLuint program) {
+    if (skip(currentProgram == program))
+      return;
+    currentProgram = program;
+    glUseProgram(program);
+  }
+  // ------------------------------------------------------------------------
+  void bindVertexArray(GLuint vao) {
+    if (skip(currentVAO == vao))
+      return;
+    currentVAO = vao;
+    glBindVertexArray(vao);
+  }
+
+  // Текстуры и сэмплеры
+  // ------------------------------------------------------------------------
+  void bindTextureUnit(GLuint unit, GLuint texture) {
+    if (unit < MAX_TEXTURE_UNITS && skip(textures[unit] == texture))
+      return;
+    if (unit < MAX_TEXTURE_UNITS)
+      textures[unit] = texture;
+    else
+      issued++;
+    glBindTextureUnit(unit, texture);
+  }
+  // Привязка блоков [first, first + count): одним вызовом glBindTextures
+  // для диапазона от первого до последнего изменившегося блока
+  // ------------------------------------------------------------------------
+  void bindTextures(GLuint first, GLsizei count, const GLuint *names) {
+    if (first + GLuint(count) > MAX_TEXTURE_UNITS) {
+      issued++;
+      glBindTextures(first, count, names);
+      return;
+    }
+    GLsizei begin = count, end = 0;
+    for (GLsizei i = 0; i < count; i++) {
+      if (textures[first + GLuint(i)] == names[i])
+        continue;
+      textures[first + GLuint(i)] = names[i];
+      begin = std::min(begin, i);
+      end = i + 1;
+    }
+    if (skip(begin >= end))
+      return;
+    glBindTextures(first + GLuint(begin), end - begin, names + begin);
+  }
+  // ------------------------------------------------------------------------
+  void bindSampler(GLuint unit, GLuint sampler) {
+    if (unit < MAX_TEXTURE_UNITS && skip(samplers[unit] == sampler))
+      return;
+    if (unit < MAX_TEXTURE_UNITS)
+      samplers[unit] = sampler;
+    else
+      issued++;
+    glBindSampler(unit, sampler);
+  }
+
+  // Буферы
+  // ------------------------------------------------------------------------
+  void bindBuffer(GLenum target, GLuint buffer) {
+    GLuint *cached = genericBinding(target);
+    if (cached && skip(*cached == buffer))
+      return;
+    if (cached)
+      *cached = buffer;
+    else
+      issued++;
+    glBindBuffer(target, buffer);
+  }
+  // ------------------------------------------------------------------------
+  void bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    IndexedBinding *cached = indexedBinding(target, index);
+    if (cached && skip(cached->buffer == buffer && cached->whole))
+      return;
+    if (cached)
+      *cached = {buffer, 0, 0, true};
+    else
+      issued++;
+    // Буфер привязывается и к общей точке target
+    if (GLuint *generic = genericBinding(target))
+      *generic = buffer;
+    glBindBufferBase(target, index, buffer);
+  }
+  // ------------------------------------------------------------------------
+  void bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                       GLintptr offset, GLsizeiptr size) {
+    IndexedBinding *cached = indexedBinding(target, index);
+    if (cached && skip(cached->buffer == buffer && !cached->whole &&
+                       cached->offset == offset && cached->size == size))
+      return;
+    if (cached)
+      *cached = {buffer, offset, size, false};
+    else
+      issued++;
+    if (GLuint *generic = genericBinding(target))
+      *generic = buffer;
+    glBindBufferRange(target, index, buffer, offset, size);
+  }
+
+  // Буфер кадра
+  // ------------------------------------------------------------------------
+  void bindFramebuffer(GLenum target, GLuint framebuffer) {
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    if (skip((!draw || drawFramebuffer == framebuffer) &&
+             (!read || readFramebuffer == framebuffer)))
+      return;
+    if (draw)
+      drawFramebuffer = framebuffer;
+    if (read)
+      readFramebuffer = framebuffer;
+    glBindFramebuffer(target, framebuffer);
+  }
+
+  // Фиксированные стадии конвейера
+  // ------------------------------------------------------------------------
+  void enable(GLenum cap) { setEnabled(cap, true); }
+  void disable(GLenum cap) { setEnabled(cap, false); }
+  // ------------------------------------------------------------------------
+  void setEnabled(GLenum cap, bool enabled) {
+    Toggle *cached = capability(cap);
+    if (cached && skip(*cached == (enabled ? Toggle::On : Toggle::Off)))
+      return;
+    if (cached)
+      *cached = enabled ? Toggle::On : Toggle::Off;
+    else
+      issued++;
+    if (enabled)
+      glEnable(cap);
+    else
+      glDisable(cap);
+  }
+  // ------------------------------------------------------------------------
+  void depthFunc(GLenum func) {
+    if (skip(currentDepthFunc == func))
+      return;
+    currentDepthFunc = func;
+    glDepthFunc(func);
+  }
+  // ------------------------------------------------------------------------
+  void depthMask(GLboolean flag) {
+    if (skip(currentDepthMask == flag))
+      return;
+    currentDepthMask = flag;
+    glDepthMask(flag);
+  }
+  // ------------------------------------------------------------------------
+  void colorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a) {
+    GLuint mask = GLuint(r != 0) | GLuint(g != 0) << 1 |
+                  GLuint(b != 0) << 2 | GLuint(a != 0) << 3;
+    if (skip(currentColorMask == mask))
+      return;
+    currentColorMask = mask;
+    glColorMask(r, g, b, a);
+  }
+  // ------------------------------------------------------------------------
+  void blendFunc(GLenum sfactor, GLenum dfactor) {
+    if (skip(blendSource == sfactor && blendDestination == dfactor))
+      return;
+    blendSource = sfactor;
+    blendDestination = dfactor;
+    glBlendFunc(sfactor, dfactor);
+  }
+  // ------------------------------------------------------------------------
+  void polygonMode(GLenum face, GLenum mode) {
+    // В core-профиле допустим только GL_FRONT_AND_BACK
+    if (skip(face == GL_FRONT_AND_BACK && currentPolygonMode == mode))
+      return;
+    currentPolygonMode = face == GL_FRONT_AND_BACK ? mode : UNKNOWN;
+    glPolygonMode(face, mode);
+  }
+
+  // Удаление объектов (привязки удаленных объектов забываются)
+  // ------------------------------------------------------------------------
+  void deleteProgram(GLuint program) {
+    if (currentProgram == program)
+      currentProgram = UNKNOWN;
+    glDeleteProgram(program);
+  }
+  // ------------------------------------------------------------------------
+  void deleteVertexArrays(GLsizei n, const GLuint *names) {
+    for (GLsizei i = 0; i < n; i++)
+      if (names[i] && currentVAO == names[i])
+        currentVAO = UNKNOWN;
+    glDeleteVertexArrays(n, names);
+  }
+  // ------------------------------------------------------------------------
+  void deleteTextures(GLsizei n, const GLuint *names) {
+    for (GLsizei i = 0; i < n; i++)
+      if (names[i])
+        std::replace(std::begin(textures), std::end(textures), names[i],
+                     UNKNOWN);
+    glDeleteTextures(n, names);
+  }
+  // ------------------------------------------------------------------------
+  void deleteBuffers(GLsizei n, const GLuint *names) {
+    for (GLsizei i = 0; i < n; i++) {
+      if (!names[i])
+        continue;
+      for (GLuint &buffer : genericBuffers)
+        if (buffer == names[i])
+          buffer = UNKNOWN;
+      for (auto &bindings : indexedBuffers)
+        for (IndexedBinding &binding : bindings)
+          if (binding.buffer == names[i])
+            binding.buffer = UNKNOWN;
+    }
+    glDeleteBuffers(n, names);
+  }
+  // ------------------------------------------------------------------------
+  void deleteFramebuffers(GLsizei n, const GLuint *names) {
+    for (GLsizei i = 0; i < n; i++) {
+      if (names[i] && drawFramebuffer == names[i])
+        drawFramebuffer = UNKNOWN;
+      if (names[i] && readFramebuffer == names[i])
+        readFramebuffer = UNKNOWN;
+    }
+    glDeleteFramebuffers(n, names);
+  }
+
+  // Сброс кеша: состояние менял код вне GLState (например, ImGui)
+  // ------------------------------------------------------------------------
+  void invalidate() {
+    currentProgram = currentVAO = UNKNOWN;
+    std::fill(std::begin(textures), std::end(textures), UNKNOWN);
+    std::fill(std::begin(samplers), std::end(samplers), UNKNOWN);
+    std::fill(std::begin(genericBuffers), std::end(genericBuffers), UNKNOWN);
+    for (auto &bindings : indexedBuffers)
+      std::fill(std::begin(bindings), std::end(bindings), IndexedBinding{});
+    drawFramebuffer = readFramebuffer = UNKNOWN;
+    std::fill(std::begin(capabilities), std::end(capabilities),
+              Toggle::Unknown);
+    currentDepthFunc = blendSource = blendDestination = UNKNOWN;
+    currentDepthMask = currentColorMask = currentPolygonMode = UNKNOWN;
+  }
+
+  // Счетчики
+  // ------------------------------------------------------------------------
+  // Конец кадра: счетчики кадра сохраняются и обнуляются
+  void endFrame() {
+    lastIssued = issued;
+    lastSkipped = skipped;
+    issued = skipped = 0;
+  }
+  // Выполненные и пропущенные вызовы за прошлый кадр
+  std::uint64_t frameIssued() const { return lastIssued; }
+  std::uint64_t frameSkipped() const { return lastSkipped; }
+
+private:
+  // Значение "неизвестно": первый вызов после сброса всегда выполняется
+  static constexpr GLuint UNKNOWN = ~0u;
+
+  enum class Toggle : std::uint8_t { Unknown, Off, On };
+
+  struct IndexedBinding {
+    GLuint buffer = UNKNOWN;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+    bool whole = false;
+  };
+
+  // Общие точки привязки буферов
+  static constexpr GLenum BUFFER_TARGETS[] = {
+      GL_ARRAY_BUFFER,         GL_ELEMENT_ARRAY_BUFFER,
+      GL_UNIFORM_BUFFER,       GL_SHADER_STORAGE_BUFFER,
+      GL_DRAW_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER,
+      GL_PIXEL_UNPACK_BUFFER,  GL_PIXEL_PACK_BUFFER,
+      GL_COPY_READ_BUFFER,     GL_COPY_WRITE_BUFFER,
+  };
+  // Индексированные точки привязки (UBO и SSBO)
+  static constexpr GLenum INDEXED_TARGETS[] = {GL_UNIFORM_BUFFER,
+                                               GL_SHADER_STORAGE_BUFFER};
+  // Отслеживаемые флаги glEnable/glDisable
+  static constexpr GLenum CAPABILITIES[] = {
+      GL_DEPTH_TEST,   GL_BLEND,        GL_CULL_FACE,
+      GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_FRAMEBUFFER_SRGB,
+  };
+
+  GLuint currentProgram, currentVAO;
+  GLuint textures[MAX_TEXTURE_UNITS];
+  GLuint samplers[MAX_TEXTURE_UNITS];
+  GLuint genericBuffers[std::size(BUFFER_TARGETS)];
+  IndexedBinding indexedBuffers[std::size(INDEXED_TARGETS)]
+                               [MAX_BUFFER_BINDINGS];
+  GLuint drawFramebuffer, readFramebuffer;
+  Toggle capabilities[std::size(CAPABILITIES)];
+  GLenum currentDepthFunc;
+  GLuint currentDepthMask; // GLboolean или UNKNOWN
+  GLuint currentColorMask; // Биты r, g, b, a или UNKNOWN
+  GLenum blendSource, blendDestination;
+  GLenum currentPolygonMode;
+
+  std::uint64_t issued = 0, skipped = 0;
+  std::uint64_t lastIssued = 0, lastSkipped = 0;
+
+  GLState() { invalidate(); }
+
+  // Подсчет вызова: true - вызов лишний и пропускается
+  bool skip(bool redundant) {
+    if (redundant)
+      skipped++;
+    else
+      issued++;
+    return redundant;
+  }
+
+  GLuint *genericBinding(GLenum target) {
+    for (std::size_t i = 0; i < std::size(BUFFER_TARGETS); i++)
+      if (BUFFER_TARGETS[i] == target)
+        return &genericBuffers[i];
+    return nullptr;
+  }
+
+  IndexedBinding *indexedBinding(GLenum target, GLuint index) {
+    if (index >= MAX_BUFFER_BINDINGS)
+      return nullptr;
+    for (std::size_t i = 0; i < std::size(INDEXED_TARGETS); i++)
+      if (INDEXED_TARGETS[i] == target)
+        return &indexedBuffers[i][index];
+    return nullptr;
+  }
+
+  Toggle *capability(GLenum cap) {
+    for (std::size_t i = 0; i < std::size(CAPABILITIES); i++)
+      if (CAPABILITIES[i] == cap)
+        return &capabilities[i];
+    return nullptr;
+  }
+};
+
+#endif
@@ -0,0 +1,407 @@
+#ifndef GEOMETRY_HEAP_H
+#define GEOMETRY_HEAP_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные библиотеки
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "GLState.h"         // Кеш состояния OpenGL
+#include "OffsetAllocator.h" // Распределитель смещений
+#include "VertexFormats.h"   // Форматы вершин
+
+// Описатель геометрии в куче
+// --------------------------
+// Индекс записи и ее поколение: после освобождения записи поколение
+// увеличивается, поэтому старые описатели становятся недействительными
+struct GeometryHandle {
+  std::uint32_t index = ~0u;
+  std::uint32_t generation = 0;
+};
+
+// Параметры отрисовки геометрии
+struct GeometryRange {
+  unsigned int vao = 0;      // VAO пула (все атрибуты)
+  unsigned int depthVAO = 0; // VAO пула (только позиции)
+  GLsizei indexCount = 0;
+  std::uint32_t firstIndex = 0; // Смещение в общем буфере индексов
+  GLint baseVertex = 0;         // Смещение в буфере вершин пула
+};
+
+// Куча геометрии
+// --------------
+// Вершины всех мешей хранятся в пулах - по одному на формат вершины и
+// способ хранения позиций (чередование или отдельный поток, см. Mesh.h);
+// у пула один immutable-буфер на поток и один VAO на все меши. Индексы всех
+// пулов лежат в общем буфере, который привязан ко всем VAO. Диапазоны
+// выделяются OffsetAllocator; меш хранит только описатель, а смещения
+// (firstIndex и baseVertex) берет из кучи при отрисовке.
+//
+// Когда подходящего свободного блока нет, буфер пересоздается большего
+// размера с копированием на GPU, а если свободного места в сумме хватает -
+// сначала уплотняется. После уплотнения смещения мешей меняются, и
+// generation() кучи увеличивается (кеши команд отрисовки по нему узнают о
+// необходимости перестроения). Работает только с потока контекста.
+class GeometryHeap {
+public:
+  // Начальная емкость пулов (вершин) и буфера индексов (индексов)
+  std::uint32_t initialVertices = 256 * 1024;
+  std::uint32_t initialIndices = 1024 * 1024;
+
+  // Глобальный экземпляр
+  static GeometryHeap &instance() {
+    static GeometryHeap heap;
+    return heap;
+  }
+
+  // Выделение и загрузка геометрии меша
+  template <typename VertexT>
+  GeometryHandle allocate(std::span<const VertexT> vertices,
+                          std::span<const unsigned int> indices,
+                          bool splitPositions) {
+    splitPositions =
+        splitPositions && sizeof(VertexT) > sizeof(VertexPosition);
+    std::uint32_t poolIndex = poolOf(VertexFormat<VertexT>::id, splitPositions);
+    Pool &pool = pools[poolIndex];
+    if (!pool.vao)
+      createPool<VertexT>(pool, splitPositions);
+
+    auto vertexCount = static_cast<std::uint32_t>(vertices.size());
+    auto indexCount = static_cast<std::uint32_t>(indices.size());
+    std::uint32_t vertexOffset = reserveVertices(poolIndex, vertexCount);
+    std::uint32_t indexOffset = reserveIndices(indexCount);
+
+    /* Вершины */
+    if (pool.split) {
+      constexpr std::size_t POSITION_SIZE = sizeof(VertexPosition);
+      constexpr std::size_t ATTRIBUTE_SIZE = sizeof(VertexT) - POSITION_SIZE;
+      std::vector<std::byte> positions(vertices.size() * POSITION_SIZE);
+      std::vector<std::byte> attributes(vertices.size() * ATTRIBUTE_SIZE);
+      for (std::size_t i = 0; i < vertices.size(); i++) {
+        const auto *bytes = reinterpret_cast<const std::byte *>(&vertices[i]);
+        std::memcpy(positions.data() + i * POSITION_SIZE, bytes,
+                    POSITION_SIZE);
+        std::memcpy(attributes.data() + i * ATTRIBUTE_SIZE,
+                    bytes + POSITION_SIZE, ATTRIBUTE_SIZE);
+      }
+      upload(pool.buffers[0], vertexOffset, pool.strides[0], positions);
+      upload(pool.buffers[1], vertexOffset, pool.strides[1], attributes);
+    } else {
+      upload(pool.buffers[0], vertexOffset, pool.strides[0],
+             std::as_bytes(vertices));
+    }
+    /* Индексы */
+    upload(indexBuffer, indexOffset, sizeof(unsigned int),
+           std::as_bytes(indices));
+
+    Slot slot{0, true, poolIndex, vertexOffset, vertexCount, indexOffset,
+              indexCount};
+    GeometryHandle handle;
+    if (!freeSlots.empty()) {
+      handle.index = freeSlots.back();
+      freeSlots.pop_back();
+      slot.generation = slots[handle.index].generation;
+      slots[handle.index] = slot;
+    } else {
+      handle.index = static_cast<std::uint32_t>(slots.size());
+      slots.push_back(slot);
+    }
+    handle.generation = slot.generation;
+    return handle;
+  }
+
+  // Освобождение геометрии (недействительные описатели игнорируются)
+  void free(GeometryHandle handle) {
+    if (!valid(handle))
+      return;
+    Slot &slot = slots[handle.index];
+    pools[slot.pool].allocator.free(slot.vertexOffset);
+    indexAllocator.free(slot.indexOffset);
+    slot.live = false;
+    slot.generation++;
+    freeSlots.push_back(handle.index);
+  }
+
+  // Проверка описателя
+  bool valid(GeometryHandle handle) const {
+    return handle.index < slots.size() && slots[handle.index].live &&
+           slots[handle.index].generation == handle.generation;
+  }
+
+  // Параметры отрисовки (пустые для недействительного описателя)
+  GeometryRange range(GeometryHandle handle) const {
+    if (!valid(handle))
+      return {};
+    const Slot &slot = slots[handle.index];
+    const Pool &pool = pools[slot.pool];
+    return {pool.vao, pool.depthVAO, static_cast<GLsizei>(slot.indexCount),
+            slot.indexOffset, static_cast<GLint>(slot.vertexOffset)};
+  }
+
+  // Уплотнение всех пулов и буфера индексов
+  void defragment() {
+    for (std::uint32_t p = 0; p < POOL_COUNT; p++)
+      if (pools[p].vao)
+        defragmentPool(p);
+    defragmentIndices();
+  }
+
+  // Номер раскладки: увеличивается при каждом перемещении геометрии
+  std::uint64_t generation() const { return layoutGeneration; }
+
+  // Доля свободного места, недоступная одним блоком (0 - нет фрагментации)
+  float fragmentation() const {
+    std::uint64_t available = indexAllocator.available();
+    std::uint64_t largest = indexAllocator.largestFree();
+    for (const Pool &pool : pools) {
+      available += pool.allocator.available();
+      largest += pool.allocator.largestFree();
+    }
+    return available ? 1.f - float(largest) / float(available) : 0.f;
+  }
+
+  // Завершение работы (до уничтожения контекста)
+  void shutdown() {
+    for (Pool &pool : pools) {
+      GLState::instance().deleteVertexArrays(1, &pool.vao);
+      GLState::instance().deleteVertexArrays(1, &pool.depthVAO);
+      GLState::instance().deleteBuffers(2, pool.buffers);
+      pool = Pool{};
+    }
+    GLState::instance().deleteBuffers(1, &indexBuffer);
+    indexBuffer = 0;
+    indexAllocator.reset(0);
+    slots.clear();
+    freeSlots.clear();
+  }
+
+private:
+  // Пулы: по одному на формат вершины и способ хранения позиций
+  static constexpr std::uint32_t FORMAT_COUNT =
+      std::uint32_t(VertexFormatId::Skinned) + 1;
+  static constexpr std::uint32_t POOL_COUNT = FORMAT_COUNT * 2;
+
+  struct Pool {
+    bool split = false;
+    std::uint32_t streams = 0;
+    GLsizei strides[2] = {};
+    unsigned int buffers[2] = {};
+    unsigned int vao = 0;
+    unsigned int depthVAO = 0;
+    OffsetAllocator allocator;
+  };
+
+  // Запись о геометрии меша
+  struct Slot {
+    std::uint32_t generation;
+    bool live;
+    std::uint32_t pool;
+    std::uint32_t vertexOffset, vertexCount;
+    std::uint32_t indexOffset, indexCount;
+  };
+
+  std::array<Pool, POOL_COUNT> pools;
+  unsigned int indexBuffer = 0;
+  OffsetAllocator indexAllocator;
+  std::vector<Slot> slots;
+  std::vector<std::uint32_t> freeSlots;
+  std::uint64_t layoutGeneration = 0;
+
+  GeometryHeap() = default;
+
+  static std::uint32_t poolOf(VertexFormatId format, bool split) {
+    return std::uint32_t(format) * 2 + (split ? 1 : 0);
+  }
+
+  // Создание пула формата VertexT
+  template <typename VertexT> void createPool(Pool &pool, bool split) {
+    pool.split = split;
+    pool.streams = split ? 2 : 1;
+    pool.strides[0] = split ? sizeof(VertexPosition) : sizeof(VertexT);
+    pool.strides[1] = split ? sizeof(VertexT) - sizeof(VertexPosition) : 0;
+
+    glCreateVertexArrays(1, &pool.vao);
+    glCreateVertexArrays(1, &pool.depthVAO);
+    if constexpr (sizeof(VertexT) > sizeof(VertexPosition))
+      if (split)
+        setupSplitVertexLayout<VertexT, VertexPosition>(pool.vao, 0, 1);
+    if (!split)
+      setupVertexLayout<VertexT>(pool.vao, 0);
+    setupVertexLayout<VertexPosition>(pool.depthVAO, 0);
+
+    if (!indexBuffer)
+      resizeIndices(initialIndices);
+    resizePool(pool, initialVertices);
+  }
+
+  // Пересоздание буферов пула с емкостью capacity и копированием занятой
+  // части (offsets: новые смещения для старых, если пул уплотняется)
+  void resizePool(Pool &pool, std::uint32_t capacity,
+                  const std::vector<std::pair<std::uint32_t, std::uint32_t>>
+                      *moves = nullptr) {
+    for (std::uint32_t s = 0; s < pool.streams; s++) {
+      unsigned int buffer = createBuffer(capacity, pool.strides[s]);
+      if (pool.buffers[s]) {
+        if (moves)
+          copyMoves(pool.buffers[s], buffer, *moves, pool.allocator,
+                    pool.strides[s]);
+        else
+          glCopyNamedBufferSubData(
+              pool.buffers[s], buffer, 0, 0,
+              GLsizeiptr(pool.allocator.capacity()) * pool.strides[s]);
+        GLState::instance().deleteBuffers(1, &pool.buffers[s]);
+      }
+      pool.buffers[s] = buffer;
+      glVertexArrayVertexBuffer(pool.vao, s, buffer, 0, pool.strides[s]);
+    }
+    glVertexArrayVertexBuffer(pool.depthVAO, 0, pool.buffers[0], 0,
+                              pool.strides[0]);
+    glVertexArrayElementBuffer(pool.vao, indexBuffer);
+    glVertexArrayElementBuffer(pool.depthVAO, indexBuffer);
+    pool.allocator.grow(capacity);
+  }
+
+  // Пересоздание буфера индексов
+  void resizeIndices(std::uint32_t capacity,
+                     const std::vector<std::pair<std::uint32_t, std::uint32_t>>
+                         *moves = nullptr) {
+    unsigned int buffer = createBuffer(capacity, sizeof(unsigned int));
+    if (indexBuffer) {
+      if (moves)
+        copyMoves(indexBuffer, buffer, *moves, indexAllocator,
+                  sizeof(unsigned int));
+      else
+        glCopyNamedBufferSubData(indexBuffer, buffer, 0, 0,
+                                 GLsizeiptr(indexAllocator.capacity()) *
+                                     GLsizeiptr(sizeof(unsigned int)));
+      GLState::instance().deleteBuffers(1, &indexBuffer);
+    }
+    indexBuffer = buffer;
+    for (Pool &pool : pools)
+      if (pool.vao) {
+        glVertexArrayElementBuffer(pool.vao, indexBuffer);
+        glVertexArrayElementBuffer(pool.depthVAO, indexBuffer);
+      }
+    indexAllocator.grow(capacity);
+  }
+
+  // Резервирование вершин в пуле (с уплотнением или ростом при нехватке)
+  std::uint32_t reserveVertices(std::uint32_t poolIndex, std::uint32_t count) {
+    Pool &pool = pools[poolIndex];
+    std::uint32_t offset = pool.allocator.allocate(count);
+    if (offset != OffsetAllocator::INVALID || count == 0)
+      return offset;
+    if (pool.allocator.available() >= count) {
+      defragmentPool(poolIndex);
+      offset = pool.allocator.allocate(count);
+    }
+    if (offset == OffsetAllocator::INVALID) {
+      std::uint32_t capacity = grownCapacity(pool.allocator, count);
+      std::cout << "INFO::GEOMETRY_HEAP::POOL_" << poolIndex << "::GROW "
+                << pool.allocator.capacity() << " -> " << capacity
+                << " vertices" << std::endl;
+      resizePool(pool, capacity);
+      offset = pool.allocator.allocate(count);
+    }
+    return offset;
+  }
+
+  // Резервирование индексов (с уплотнением или ростом при нехватке)
+  std::uint32_t reserveIndices(std::uint32_t count) {
+    std::uint32_t offset = indexAllocator.allocate(count);
+    if (offset != OffsetAllocator::INVALID || count == 0)
+      return offset;
+    if (indexAllocator.available() >= count) {
+      defragmentIndices();
+      offset = indexAllocator.allocate(count);
+    }
+    if (offset == OffsetAllocator::INVALID) {
+      std::uint32_t capacity = grownCapacity(indexAllocator, count);
+      std::cout << "INFO::GEOMETRY_HEAP::INDICES::GROW "
+                << indexAllocator.capacity() << " -> " << capacity
+                << std::endl;
+      resizeIndices(capacity);
+      offset = indexAllocator.allocate(count);
+    }
+    return offset;
+  }
+
+  // Новая емкость: удвоение, пока не поместится count элементов в конце
+  static std::uint32_t grownCapacity(const OffsetAllocator &allocator,
+                                     std::uint32_t count) {
+    std::uint64_t capacity = std::max<std::uint64_t>(allocator.capacity(), 1);
+    while (capacity < std::uint64_t(allocator.capacity()) + count)
+      capacity *= 2;
+    return static_cast<std::uint32_t>(
+        std::min<std::uint64_t>(capacity, OffsetAllocator::INVALID - 1));
+  }
+
+  // Уплотнение пула: занятые диапазоны копируются в начало нового буфера
+  void defragmentPool(std::uint32_t poolIndex) {
+    Pool &pool = pools[poolIndex];
+    auto moves = pool.allocator.compact();
+    std::unordered_map<std::uint32_t, std::uint32_t> remap(moves.begin(),
+                                                           moves.end());
+    std::uint32_t capacity = pool.allocator.capacity();
+    resizePool(pool, capacity, &moves);
+    for (Slot &slot : slots)
+      if (slot.live && slot.pool == poolIndex)
+        if (auto it = remap.find(slot.vertexOffset); it != remap.end())
+          slot.vertexOffset = it->second;
+    layoutGeneration++;
+  }
+
+  // Уплотнение буфера индексов
+  void defragmentIndices() {
+    auto moves = indexAllocator.compact();
+    std::unordered_map<std::uint32_t, std::uint32_t> remap(moves.begin(),
+                                                           moves.end());
+    resizeIndices(indexAllocator.capacity(), &moves);
+    for (Slot &slot : slots)
+      if (slot.live)
+        if (auto it = remap.find(slot.indexOffset); it != remap.end())
+          slot.indexOffset = it->second;
+    layoutGeneration++;
+  }
+
+  // Буфер под capacity элементов размера stride
+  static unsigned int createBuffer(std::uint32_t capacity, GLsizei stride) {
+    unsigned int buffer;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, GLsizeiptr(capacity) * stride, nullptr,
+                         GL_DYNAMIC_STORAGE_BIT);
+    return buffer;
+  }
+
+  // Копирование перемещенных диапазонов (allocator уже уплотнен)
+  static void
+  copyMoves(unsigned int from, unsigned int to,
+            const std::vector<std::pair<std::uint32_t, std::uint32_t>> &moves,
+            const OffsetAllocator &allocator, GLsizei stride) {
+    for (const auto &[oldOffset, newOffset] : moves)
+      glCopyNamedBufferSubData(from, to, GLintptr(oldOffset) * stride,
+                               GLintptr(newOffset) * stride,
+                               GLsizeiptr(allocator.sizeOf(newOffset)) *
+                                   stride);
+  }
+
+  // Загрузка данных по смещению offset (в элементах размера stride)
+  static void upload(unsigned int buffer, std::uint32_t offset,
+                     GLsizei stride, std::span<const std::byte> data) {
+    if (!data.empty())
+      glNamedBufferSubData(buffer, GLintptr(offset) * stride,
+                           static_cast<GLsizeiptr>(data.size()), data.data());
+  }
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef GPU_COUNTER_H
+#define GPU_COUNTER_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Счетчик GPU
+// -----------
+// Запрос-счетчик (GL_TIME_ELAPSED, GL_SAMPLES_PASSED,
+// GL_FRAGMENT_SHADER_INVOCATIONS и другие запросы статистики конвейера)
+// между begin() и end(). Запросы образуют кольцо из LATENCY штук, и
+// результат читается через LATENCY кадров, когда он уже готов, поэтому
+// замер не останавливает конвейер. Одновременно активен только один запрос
+// каждого типа.
+class GpuCounter {
+public:
+  // Число кадров между замером и чтением результата
+  static constexpr unsigned int LATENCY = 4;
+
+  explicit GpuCounter(GLenum queryTarget) : target(queryTarget) {
+    glCreateQueries(target, LATENCY, queries);
+  }
+
+  GpuCounter(const GpuCounter &) = delete;
+  GpuCounter &operator=(const GpuCounter &) = delete;
+
+  // Начало замера
+  void begin() { glBeginQuery(target, queries[frame % LATENCY]); }
+
+  // Конец замера и чтение самого старого готового результата
+  void end() {
+    glEndQuery(target);
+    frame++;
+    if (frame < LATENCY)
+      return;
+
+    GLuint query = queries[frame % LATENCY];
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      return;
+    GLuint64 count = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &count);
+
+    // Экспоненциальное сглаживание
+    double sample = double(count);
+    average = samples++ == 0 ? sample : average * 0.9 + sample * 0.1;
+  }
+
+  // Сглаженное значение (0, пока нет результатов)
+  double value() const { return average; }
+
+  // Сброс накопленных результатов
+  void reset() {
+    average = 0.0;
+    samples = 0;
+  }
+
+  // Удаление запросов (до уничтожения контекста)
+  void release() {
+    glDeleteQueries(LATENCY, queries);
+    for (GLuint &query : queries)
+      query = 0;
+  }
+
+private:
+  GLenum target;
+  GLuint queries[LATENCY] = {};
+  unsigned long long frame = 0;
+  unsigned long long samples = 0;
+  double average = 0.0;
+};
+
+#endif
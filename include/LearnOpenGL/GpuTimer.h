@@ -0,0 +1,34 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные заголовочные файлы
+#include "GpuCounter.h" // Счетчик GPU
+
+// Таймер GPU
+// ----------
+// Счетчик GL_TIME_ELAPSED (см. GpuCounter.h): замеряет время выполнения
+// команд между begin() и end(). Запросы GL_TIME_ELAPSED не могут быть
+// вложенными: одновременно активен только один таймер.
+class GpuTimer {
+public:
+  // Начало и конец замера
+  void begin() { counter.begin(); }
+  void end() { counter.end(); }
+
+  // Сглаженное время в миллисекундах (0, пока нет результатов)
+  double milliseconds() const { return counter.value() * 1e-6; }
+
+  // Сброс накопленных результатов
+  void reset() { counter.reset(); }
+
+  // Удаление запросов (до уничтожения контекста)
+  void release() { counter.release(); }
+
+private:
+  GpuCounter counter{GL_TIME_ELAPSED};
+};
+
+#endif
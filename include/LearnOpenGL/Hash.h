@@ -0,0 +1,56 @@
+#ifndef HASH_H
+#define HASH_H
+
+// Остальные библиотеки
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Остальные заголовочные файлы
+#include "MappedFile.h" // Отображение файла в память
+
+// Хеширование FNV-1a (64 бита)
+// ----------------------------
+constexpr std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+// Хеш произвольного блока памяти (seed позволяет хешировать по частям)
+inline std::uint64_t hashBytes(const void *data, std::size_t size,
+                               std::uint64_t seed = FNV_OFFSET_BASIS) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  std::uint64_t hash = seed;
+  for (std::size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+// Хеш строки
+constexpr std::uint64_t hashString(std::string_view str,
+                                   std::uint64_t seed = FNV_OFFSET_BASIS) {
+  std::uint64_t hash = seed;
+  for (char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+// Хеш значения тривиального типа
+template <typename T>
+inline std::uint64_t hashValue(const T &value,
+                               std::uint64_t seed = FNV_OFFSET_BASIS) {
+  return hashBytes(&value, sizeof(T), seed);
+}
+
+// Хеш содержимого файла (0, если файл недоступен)
+inline std::uint64_t hashFile(const std::string &path) {
+  MappedFile file(path);
+  if (!file.isOpen())
+    return 0;
+  return hashBytes(file.data(), file.size());
+}
+
+#endif
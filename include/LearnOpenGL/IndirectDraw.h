@@ -0,0 +1,280 @@
+#ifndef INDIRECT_DRAW_H
+#define INDIRECT_DRAW_H
+
+// GLAD
+#include "glad/gl.h"
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "GeometryHeap.h" // Куча геометрии
+#include "GLState.h"      // Кеш состояния OpenGL
+#include "Hash.h"         // Хеширование
+#include "Mesh.h"         // Класс меша
+#include "Shader.h"       // Класс шейдера
+
+// Точки привязки SSBO непрямой отрисовки (см. lightVertexShader.glsl)
+constexpr GLuint INDIRECT_DRAW_BINDING = 0;
+constexpr GLuint INDIRECT_TRANSFORM_BINDING = 1;
+
+// Команда glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+  std::uint32_t count;
+  std::uint32_t instanceCount;
+  std::uint32_t firstIndex;
+  std::int32_t baseVertex;
+  std::uint32_t baseInstance;
+};
+
+// Параметры одной отрисовки (std430, индекс drawBase + gl_DrawID)
+struct IndirectDrawData {
+  float posOffset[3];
+  std::uint32_t transform; // Индекс трансформации первого экземпляра
+  float posScale[3];
+  std::uint32_t padding;
+};
+
+// Трансформация (std430)
+struct IndirectTransform {
+  glm::mat4 model;
+  glm::mat4 normalMatrix; // Используется верхний левый блок 3x3
+};
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 20 &&
+              sizeof(IndirectDrawData) == 32 &&
+              sizeof(IndirectTransform) == 128);
+
+// Загрузка данных в буфер (буфер пересоздается, если не хватает места)
+inline void uploadIndirectBuffer(unsigned int &buffer, std::size_t &capacity,
+                                 const void *data, std::size_t size) {
+  if (size == 0)
+    return;
+  if (size > capacity) {
+    GLState::instance().deleteBuffers(1, &buffer);
+    capacity = std::max(size, capacity * 2);
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(capacity), nullptr,
+                         GL_DYNAMIC_STORAGE_BIT);
+  }
+  glNamedBufferSubData(buffer, 0, static_cast<GLsizeiptr>(size), data);
+}
+
+// Список непрямой отрисовки
+// -------------------------
+// Каждый кадр в список добавляются трансформации и меши; draw() рисует
+// весь список несколькими вызовами glMultiDrawElementsIndirect - по одному
+// на сочетание VAO пула кучи геометрии и набора текстур (без bindless-
+// текстур их нельзя сменить внутри вызова). Параметры меша берутся шейдером
+// из SSBO по drawBase + gl_DrawID, индекс параметров материала - из
+// baseInstance команды, поэтому меши с разным блеском попадают в один вызов.
+//
+// Буфер команд перестраивается, только если изменился состав списка или
+// геометрия в куче переместилась (GeometryHeap::generation); иначе за кадр
+// загружаются только трансформации.
+class IndirectDrawList {
+public:
+  // Очистка списка (буферы и построенные команды сохраняются)
+  void clear() {
+    transforms.clear();
+    draws.clear();
+    transformsUploaded = false;
+  }
+
+  // Добавление трансформации, возвращает ее индекс
+  std::uint32_t addTransform(const glm::mat4 &model) {
+    transforms.push_back({model, glm::transpose(glm::inverse(model))});
+    transformsUploaded = false;
+    return static_cast<std::uint32_t>(transforms.size() - 1);
+  }
+
+  // Добавление меша. Экземпляры используют трансформации
+  // [transform, transform + instanceCount)
+  template <typename VertexT>
+  void add(const Mesh<VertexT> &mesh, std::uint32_t transform,
+           std::uint32_t instanceCount = 1) {
+    draws.push_back({mesh.geometry, &mesh.material, mesh.materialFeatures,
+                     mesh.quantization, transform, instanceCount});
+  }
+
+  // Отрисовка списка
+  // (material - только меши с этим набором возможностей материала, см.
+  // ShaderVariants.h)
+  void draw(Shader &shader, std::uint32_t material = ANY_MATERIAL) {
+    submit(shader, material, false);
+  }
+
+  // Отрисовка списка только позициями (VAO пулов без атрибутов, кроме
+  // позиции, и без материалов)
+  void drawDepth(Shader &shader) { submit(shader, ANY_MATERIAL, true); }
+
+  // Число вызовов glMultiDrawElementsIndirect последней отрисовки
+  std::size_t batchCount() const { return batches.size(); }
+  // Число мешей в списке
+  std::size_t drawCount() const { return draws.size(); }
+
+  // Удаление буферов (до уничтожения контекста)
+  void release() {
+    GLState::instance().deleteBuffers(1, &commandBuffer);
+    GLState::instance().deleteBuffers(1, &drawBuffer);
+    GLState::instance().deleteBuffers(1, &transformBuffer);
+    commandBuffer = drawBuffer = transformBuffer = 0;
+    commandCapacity = drawCapacity = transformCapacity = 0;
+    builtKey = 0;
+    transformsUploaded = false;
+  }
+
+private:
+  // Меш в списке
+  struct Draw {
+    GeometryHandle geometry;
+    const MaterialBinding *material;
+    std::uint32_t features;
+    VertexQuantization quantization;
+    std::uint32_t transform;
+    std::uint32_t instanceCount;
+  };
+
+  // Вызов glMultiDrawElementsIndirect: команды [first, first + count)
+  struct Batch {
+    unsigned int vao, depthVAO;
+    const MaterialBinding *material;
+    std::uint32_t features;
+    std::uint32_t first, count;
+  };
+
+  std::vector<IndirectTransform> transforms;
+  std::vector<Draw> draws;
+  std::vector<Batch> batches;
+  std::uint64_t builtKey = 0;
+  std::uint64_t builtGeneration = 0;
+  bool transformsUploaded = false;
+  unsigned int commandBuffer = 0, drawBuffer = 0, transformBuffer = 0;
+  std::size_t commandCapacity = 0, drawCapacity = 0, transformCapacity = 0;
+
+  // Загрузка трансформаций и вызовы glMultiDrawElementsIndirect
+  void submit(Shader &shader, std::uint32_t material, bool depthOnly) {
+    if (draws.empty())
+      return;
+    std::uint64_t key = drawsKey();
+    if (key != builtKey || GeometryHeap::instance().generation() !=
+                               builtGeneration)
+      build(key);
+    // Трансформации загружаются один раз после изменения списка, поэтому
+    // проход глубины и проход цвета одного кадра загружают их однократно
+    if (!transformsUploaded) {
+      uploadIndirectBuffer(transformBuffer, transformCapacity,
+                           transforms.data(),
+                           transforms.size() * sizeof(IndirectTransform));
+      transformsUploaded = true;
+    }
+
+    GLState &state = GLState::instance();
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INDIRECT_DRAW_BINDING,
+                         drawBuffer);
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INDIRECT_TRANSFORM_BINDING,
+                         transformBuffer);
+    state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    const Shader::DrawUniforms &uniforms = shader.drawUniforms();
+    uniforms.indirectDraw.set(true);
+    for (const Batch &batch : batches) {
+      if (material != ANY_MATERIAL && batch.features != material)
+        continue;
+      if (!depthOnly)
+        batch.material->bind();
+      uniforms.drawBase.set(batch.first);
+      state.bindVertexArray(depthOnly ? batch.depthVAO : batch.vao);
+      glMultiDrawElementsIndirect(
+          GL_TRIANGLES, GL_UNSIGNED_INT,
+          reinterpret_cast<const void *>(std::uintptr_t(batch.first) *
+                                         sizeof(DrawElementsIndirectCommand)),
+          static_cast<GLsizei>(batch.count), 0);
+    }
+    uniforms.indirectDraw.set(false);
+    state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+
+  // Хеш состава списка (геометрия, материал и трансформация каждого меша)
+  std::uint64_t drawsKey() const {
+    std::uint64_t hash = hashValue(draws.size());
+    for (const Draw &draw : draws) {
+      hash = hashValue(draw.geometry, hash);
+      hash = hashValue(draw.material->textures, hash);
+      hash = hashValue(draw.material->index, hash);
+      hash = hashValue(draw.quantization, hash);
+      hash = hashValue(draw.transform, hash);
+      hash = hashValue(draw.instanceCount, hash);
+    }
+    return hash;
+  }
+
+  // Хеш набора текстур материала (параметры материала не разделяют
+  // вызовы: их индекс передается в baseInstance)
+  static std::uint64_t materialKey(const Draw &draw) {
+    return hashValue(draw.material->textures);
+  }
+
+  // Построение команд: меши сортируются по VAO и материалу, и каждая
+  // непрерывная группа становится одним вызовом
+  void build(std::uint64_t key) {
+    const GeometryHeap &heap = GeometryHeap::instance();
+    struct Sorted {
+      unsigned int vao;
+      std::uint64_t material;
+      GeometryRange range;
+      const Draw *draw;
+    };
+    std::vector<Sorted> sorted;
+    sorted.reserve(draws.size());
+    for (const Draw &draw : draws) {
+      GeometryRange range = heap.range(draw.geometry);
+      if (range.vao && range.indexCount > 0 && draw.instanceCount > 0)
+        sorted.push_back({range.vao, materialKey(draw), range, &draw});
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const Sorted &a, const Sorted &b) {
+                       return a.vao != b.vao ? a.vao < b.vao
+                                             : a.material < b.material;
+                     });
+
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<IndirectDrawData> drawData;
+    commands.reserve(sorted.size());
+    drawData.reserve(sorted.size());
+    batches.clear();
+    for (std::size_t i = 0; i < sorted.size(); i++) {
+      const Sorted &s = sorted[i];
+      auto index = static_cast<std::uint32_t>(i);
+      if (i == 0 || s.vao != sorted[i - 1].vao ||
+          s.material != sorted[i - 1].material)
+        batches.push_back(
+            {s.vao, s.range.depthVAO, s.draw->material, s.draw->features,
+             index, 0});
+      batches.back().count++;
+
+      commands.push_back({static_cast<std::uint32_t>(s.range.indexCount),
+                          s.draw->instanceCount, s.range.firstIndex,
+                          s.range.baseVertex, s.draw->material->index});
+      const VertexQuantization &q = s.draw->quantization;
+      drawData.push_back({{q.offset.x, q.offset.y, q.offset.z},
+                          s.draw->transform,
+                          {q.scale.x, q.scale.y, q.scale.z},
+                          0});
+    }
+
+    uploadIndirectBuffer(
+        commandBuffer, commandCapacity, commands.data(),
+        commands.size() * sizeof(DrawElementsIndirectCommand));
+    uploadIndirectBuffer(drawBuffer, drawCapacity, drawData.data(),
+                         drawData.size() * sizeof(IndirectDrawData));
+    builtKey = key;
+    builtGeneration = heap.generation();
+  }
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+// GLAD
+#include "glad/gl.h"
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "GLState.h"      // Кеш состояния OpenGL
+#include "IndirectDraw.h" // Формат трансформаций и точка привязки SSBO
+#include "ThreadPool.h"   // Пул потоков
+
+// Буфер экземпляров
+// -----------------
+// Трансформации экземпляров модели в SSBO (привязка
+// INDIRECT_TRANSFORM_BINDING). Вершинный шейдер в режиме instancedDraw
+// берет матрицы по gl_InstanceID, поэтому любое число экземпляров рисуется
+// одним вызовом на меш. Матрицы модели (если они задаются функцией) и
+// нормали считаются на рабочих потоках участками по CHUNK_SIZE
+// экземпляров.
+class InstanceBuffer {
+public:
+  static constexpr std::size_t CHUNK_SIZE = 1024;
+
+  // Загрузка трансформаций экземпляров
+  void update(std::span<const glm::mat4> models) {
+    update(models.size(), [models](std::size_t i) { return models[i]; });
+  }
+
+  // Загрузка трансформаций instanceCount экземпляров; modelOf(i) - матрица
+  // модели i-го экземпляра (вызывается параллельно на рабочих потоках)
+  template <typename ModelFn>
+  void update(std::size_t instanceCount, ModelFn &&modelOf) {
+    count = instanceCount;
+    staging.resize(count);
+    std::size_t chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    ThreadPool::global().parallelFor(chunks, [&](std::size_t chunk) {
+      std::size_t last = std::min(count, (chunk + 1) * CHUNK_SIZE);
+      for (std::size_t i = chunk * CHUNK_SIZE; i < last; i++) {
+        glm::mat4 model = modelOf(i);
+        staging[i] = {model, glm::transpose(glm::inverse(model))};
+      }
+    });
+
+    std::size_t size = count * sizeof(IndirectTransform);
+    if (size == 0)
+      return;
+    if (size > capacity) {
+      GLState::instance().deleteBuffers(1, &buffer);
+      capacity = std::max(size, capacity * 2);
+      glCreateBuffers(1, &buffer);
+      glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(capacity), nullptr,
+                           GL_DYNAMIC_STORAGE_BIT);
+    }
+    glNamedBufferSubData(buffer, 0, static_cast<GLsizeiptr>(size),
+                         staging.data());
+  }
+
+  // Привязка к точке привязки трансформаций
+  void bind() const {
+    GLState::instance().bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+                                       INDIRECT_TRANSFORM_BINDING, buffer);
+  }
+
+  // Число экземпляров
+  std::size_t size() const { return count; }
+
+  // Удаление буфера (до уничтожения контекста)
+  void release() {
+    GLState::instance().deleteBuffers(1, &buffer);
+    buffer = 0;
+    capacity = 0;
+  }
+
+private:
+  unsigned int buffer = 0;
+  std::size_t capacity = 0;
+  std::size_t count = 0;
+  std::vector<IndirectTransform> staging;
+};
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef KTX2_H
+#define KTX2_H
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "BlockCompression.h" // Блочное сжатие
+#include "MappedFile.h"       // Отображение файла в память
+
+// Контейнер KTX2 для сжатых текстур
+// ---------------------------------
+// Поддерживается подмножество формата: одна 2D текстура без суперсжатия с
+// полной цепочкой mip-уровней в формате BC1/BC3/BC4/BC5. В метаданных
+// (key/value) хранится хеш исходного изображения, по которому кеш
+// проверяется на актуальность.
+namespace Ktx2 {
+
+constexpr std::uint8_t IDENTIFIER[12] = {0xAB, 'K',  'T',  'X', ' ',  '2',
+                                         '0',  0xBB, '\r', '\n', 0x1A, '\n'};
+// Ключ метаданных с хешем исходного файла
+constexpr char SOURCE_KEY[] = "LearnOpenGL.sourceHash";
+
+// Значения VkFormat
+enum VkFormat : std::uint32_t {
+  VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131,
+  VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132,
+  VK_FORMAT_BC3_UNORM_BLOCK = 137,
+  VK_FORMAT_BC3_SRGB_BLOCK = 138,
+  VK_FORMAT_BC4_UNORM_BLOCK = 139,
+  VK_FORMAT_BC5_UNORM_BLOCK = 141,
+};
+
+// VkFormat по формату блочного сжатия
+constexpr std::uint32_t vkFormat(BlockCompression::Format format, bool srgb) {
+  switch (format) {
+  case BlockCompression::Format::BC1:
+    return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+  case BlockCompression::Format::BC3:
+    return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+  case BlockCompression::Format::BC4:
+    return VK_FORMAT_BC4_UNORM_BLOCK;
+  case BlockCompression::Format::BC5:
+    return VK_FORMAT_BC5_UNORM_BLOCK;
+  }
+  return 0;
+}
+
+// Заголовок и индекс файла
+struct Header {
+  std::uint8_t identifier[12];
+  std::uint32_t vkFormat;
+  std::uint32_t typeSize;
+  std::uint32_t pixelWidth;
+  std::uint32_t pixelHeight;
+  std::uint32_t pixelDepth;
+  std::uint32_t layerCount;
+  std::uint32_t faceCount;
+  std::uint32_t levelCount;
+  std::uint32_t supercompressionScheme;
+  std::uint32_t dfdByteOffset;
+  std::uint32_t dfdByteLength;
+  std::uint32_t kvdByteOffset;
+  std::uint32_t kvdByteLength;
+  std::uint64_t sgdByteOffset;
+  std::uint64_t sgdByteLength;
+};
+static_assert(sizeof(Header) == 80);
+
+// Запись индекса уровня
+struct LevelIndex {
+  std::uint64_t byteOffset;
+  std::uint64_t byteLength;
+  std::uint64_t uncompressedByteLength;
+};
+
+namespace detail {
+
+// Базовый блок Data Format Descriptor для блочных форматов
+inline std::vector<std::uint32_t> dataFormatDescriptor(
+    BlockCompression::Format format, bool srgb) {
+  // Модели цвета KHR_DF_MODEL_* и каналы (смещение, канал)
+  std::uint32_t model = 0;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> samples;
+  switch (format) {
+  case BlockCompression::Format::BC1:
+    model = 128;
+    samples = {{0, 0}};
+    break;
+  case BlockCompression::Format::BC3:
+    model = 130;
+    samples = {{0, 15}, {64, 0}};
+    break;
+  case BlockCompression::Format::BC4:
+    model = 131;
+    samples = {{0, 0}};
+    break;
+  case BlockCompression::Format::BC5:
+    model = 132;
+    samples = {{0, 0}, {64, 1}};
+    break;
+  }
+
+  std::uint32_t blockBytes =
+      static_cast<std::uint32_t>(BlockCompression::blockSize(format));
+  std::uint32_t descriptorBlockSize =
+      24 + 16 * static_cast<std::uint32_t>(samples.size());
+  std::vector<std::uint32_t> dfd;
+  dfd.push_back(4 + descriptorBlockSize); // dfdTotalSize
+  dfd.push_back(0);                       // vendorId, descriptorType
+  dfd.push_back(2 | (descriptorBlockSize << 16));
+  // colorModel, colorPrimaries (BT709), transferFunction (linear/sRGB)
+  dfd.push_back(model | (1u << 8) | ((srgb ? 2u : 1u) << 16));
+  dfd.push_back(3 | (3 << 8)); // Блок 4x4x1x1
+  dfd.push_back(blockBytes);   // bytesPlane0
+  dfd.push_back(0);
+  for (auto [bitOffset, channel] : samples) {
+    dfd.push_back(bitOffset | (63u << 16) | (channel << 24));
+    dfd.push_back(0);           // samplePosition
+    dfd.push_back(0);           // sampleLower
+    dfd.push_back(0xFFFFFFFFu); // sampleUpper
+  }
+  return dfd;
+}
+
+} // namespace detail
+
+// Запись KTX2
+// -----------
+// levels[i] - сжатые данные уровня i (уровень 0 - самый крупный)
+inline bool write(const std::string &path, BlockCompression::Format format,
+                  bool srgb, int width, int height,
+                  const std::vector<std::vector<std::uint8_t>> &levels,
+                  std::uint64_t sourceHash) {
+  auto align = [](std::uint64_t offset, std::uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+  };
+
+  Header header = {};
+  std::memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+  header.vkFormat = vkFormat(format, srgb);
+  header.typeSize = 1;
+  header.pixelWidth = static_cast<std::uint32_t>(width);
+  header.pixelHeight = static_cast<std::uint32_t>(height);
+  header.faceCount = 1;
+  header.levelCount = static_cast<std::uint32_t>(levels.size());
+
+  // Data Format Descriptor
+  std::vector<std::uint32_t> dfd = detail::dataFormatDescriptor(format, srgb);
+  header.dfdByteOffset = static_cast<std::uint32_t>(
+      sizeof(Header) + levels.size() * sizeof(LevelIndex));
+  header.dfdByteLength =
+      static_cast<std::uint32_t>(dfd.size() * sizeof(std::uint32_t));
+
+  // Метаданные: хеш исходного файла
+  char value[17];
+  std::snprintf(value, sizeof(value), "%016llx",
+                static_cast<unsigned long long>(sourceHash));
+  std::string kvd;
+  std::uint32_t kvLength =
+      static_cast<std::uint32_t>(sizeof(SOURCE_KEY) + sizeof(value));
+  kvd.append(reinterpret_cast<const char *>(&kvLength), sizeof(kvLength));
+  kvd.append(SOURCE_KEY, sizeof(SOURCE_KEY));
+  kvd.append(value, sizeof(value));
+  kvd.resize(align(kvd.size(), 4), '\0');
+  header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+  header.kvdByteLength = static_cast<std::uint32_t>(kvd.size());
+
+  // Данные уровней записываются от меньшего к большему
+  std::uint64_t blockBytes = BlockCompression::blockSize(format);
+  std::vector<LevelIndex> index(levels.size());
+  std::uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+  for (std::size_t i = levels.size(); i-- > 0;) {
+    offset = align(offset, blockBytes);
+    index[i] = {offset, levels[i].size(), levels[i].size()};
+    offset += levels[i].size();
+  }
+
+  std::string tmpPath = temporaryPath(path);
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+      return false;
+    auto put = [&out](const void *data, std::size_t size) {
+      out.write(static_cast<const char *>(data),
+                static_cast<std::streamsize>(size));
+    };
+    put(&header, sizeof(header));
+    put(index.data(), index.size() * sizeof(LevelIndex));
+    put(dfd.data(), dfd.size() * sizeof(std::uint32_t));
+    put(kvd.data(), kvd.size());
+    for (std::size_t i = levels.size(); i-- > 0;) {
+      std::uint64_t pos = static_cast<std::uint64_t>(out.tellp());
+      static const char zeros[16] = {};
+      put(zeros, index[i].byteOffset - pos);
+      put(levels[i].data(), levels[i].size());
+    }
+    if (!out) {
+      out.close();
+      std::remove(tmpPath.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Чтение KTX2
+// -----------
+class Reader {
+public:
+  // Открытие файла; false, если файл отсутствует, поврежден, имеет другой
+  // формат или создан из другого исходного файла
+  bool open(const std::string &path, std::uint32_t expectedVkFormat,
+            std::uint64_t sourceHash) {
+    if (!file.open(path))
+      return false;
+    if (!validate(expectedVkFormat, sourceHash)) {
+      file.close();
+      return false;
+    }
+    return true;
+  }
+
+  int width() const { return static_cast<int>(header().pixelWidth); }
+  int height() const { return static_cast<int>(header().pixelHeight); }
+  std::size_t levelCount() const { return header().levelCount; }
+
+  std::span<const std::uint8_t> level(std::size_t i) const {
+    const LevelIndex &entry = levelIndex()[i];
+    return {reinterpret_cast<const std::uint8_t *>(file.data()) +
+                entry.byteOffset,
+            entry.byteLength};
+  }
+
+private:
+  MappedFile file;
+
+  const Header &header() const {
+    return *reinterpret_cast<const Header *>(file.data());
+  }
+  const LevelIndex *levelIndex() const {
+    return reinterpret_cast<const LevelIndex *>(file.data() + sizeof(Header));
+  }
+
+  bool validate(std::uint32_t expectedVkFormat,
+                std::uint64_t sourceHash) const {
+    std::uint64_t size = file.size();
+    if (size < sizeof(Header))
+      return false;
+    const Header &h = header();
+    if (std::memcmp(h.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0 ||
+        h.vkFormat != expectedVkFormat || h.supercompressionScheme != 0 ||
+        h.levelCount == 0 || h.pixelWidth == 0 || h.pixelHeight == 0 ||
+        h.pixelDepth != 0 || h.faceCount != 1 || h.layerCount > 1 ||
+        sizeof(Header) + std::uint64_t(h.levelCount) * sizeof(LevelIndex) >
+            size ||
+        std::uint64_t(h.kvdByteOffset) + h.kvdByteLength > size)
+      return false;
+    // Уровни должны образовывать цепочку mip-уровней с размерами блочного
+    // формата, иначе загрузка в GPU завершится ошибкой
+    std::uint32_t maxLevels = 1;
+    while ((std::max(h.pixelWidth, h.pixelHeight) >> maxLevels) > 0)
+      maxLevels++;
+    if (h.levelCount > maxLevels)
+      return false;
+    bool halfBlock = h.vkFormat == VK_FORMAT_BC1_RGB_UNORM_BLOCK ||
+                     h.vkFormat == VK_FORMAT_BC1_RGB_SRGB_BLOCK ||
+                     h.vkFormat == VK_FORMAT_BC4_UNORM_BLOCK;
+    std::uint64_t blockBytes = halfBlock ? 8 : 16;
+    for (std::uint32_t i = 0; i < h.levelCount; i++) {
+      const LevelIndex &entry = levelIndex()[i];
+      std::uint64_t blocksX = (std::max(1u, h.pixelWidth >> i) + 3) / 4;
+      std::uint64_t blocksY = (std::max(1u, h.pixelHeight >> i) + 3) / 4;
+      if (entry.byteOffset > size ||
+          entry.byteLength > size - entry.byteOffset ||
+          entry.byteLength != blocksX * blocksY * blockBytes)
+        return false;
+    }
+
+    // Поиск хеша исходного файла в метаданных
+    const char *kvd = reinterpret_cast<const char *>(file.data()) +
+                      h.kvdByteOffset;
+    char expected[17];
+    std::snprintf(expected, sizeof(expected), "%016llx",
+                  static_cast<unsigned long long>(sourceHash));
+    for (std::uint32_t pos = 0; pos + 4 <= h.kvdByteLength;) {
+      std::uint32_t length;
+      std::memcpy(&length, kvd + pos, sizeof(length));
+      if (length > h.kvdByteLength - pos - 4)
+        return false;
+      const char *entry = kvd + pos + 4;
+      if (length == sizeof(SOURCE_KEY) + sizeof(expected) &&
+          std::memcmp(entry, SOURCE_KEY, sizeof(SOURCE_KEY)) == 0)
+        return std::memcmp(entry + sizeof(SOURCE_KEY), expected,
+                           sizeof(expected)) == 0;
+      pos += (4 + length + 3) & ~3u;
+    }
+    return false;
+  }
+};
+
+} // namespace Ktx2
+
+#endif
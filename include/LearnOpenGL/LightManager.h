@@ -0,0 +1,425 @@
+#ifndef LIGHT_MANAGER_H
+#define LIGHT_MANAGER_H
+
+// GLAD
+#include "glad/gl.h"
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "GLState.h" // Кеш состояния OpenGL
+
+// Точки привязки SSBO источников света (см. lightFragmentShader.glsl)
+constexpr GLuint POINT_LIGHT_BINDING = 2;
+constexpr GLuint SPOT_LIGHT_BINDING = 3;
+constexpr GLuint DIR_LIGHT_BINDING = 4;
+
+// Порог освещенности, ниже которого вклад источника отбрасывается
+// (один шаг 8-битного цвета)
+constexpr float LIGHT_CUTOFF = 1.f / 256.f;
+
+// Параметры источников света
+// --------------------------
+/* Точечный */
+struct PointLightDesc {
+  glm::vec3 position = glm::vec3(0.f);
+  float linear = 0.09f;
+  float quadratic = 0.032f;
+  glm::vec3 ambient = glm::vec3(0.f);
+  glm::vec3 diffuse = glm::vec3(0.f);
+  glm::vec3 specular = glm::vec3(0.f);
+
+  bool operator==(const PointLightDesc &) const = default;
+};
+
+/* Прожектор */
+struct SpotLightDesc {
+  glm::vec3 position = glm::vec3(0.f);
+  glm::vec3 direction = glm::vec3(0.f, 0.f, -1.f);
+  float cutOff = 1.f;      // Косинус внутреннего угла
+  float outerCutOff = 1.f; // Косинус внешнего угла
+  float linear = 0.09f;
+  float quadratic = 0.032f;
+  glm::vec3 ambient = glm::vec3(0.f);
+  glm::vec3 diffuse = glm::vec3(0.f);
+  glm::vec3 specular = glm::vec3(0.f);
+
+  bool operator==(const SpotLightDesc &) const = default;
+};
+
+/* Направленный */
+struct DirLightDesc {
+  glm::vec3 direction = glm::vec3(0.f, -1.f, 0.f);
+  glm::vec3 ambient = glm::vec3(0.f);
+  glm::vec3 diffuse = glm::vec3(0.f);
+  glm::vec3 specular = glm::vec3(0.f);
+
+  bool operator==(const DirLightDesc &) const = default;
+};
+
+// Радиус действия точечного источника
+// ------------------------------------
+// Расстояние, на котором яркость max(ambient + diffuse + specular),
+// ослабленная как 1 / (1 + linear * d + quadratic * d^2), падает до
+// LIGHT_CUTOFF. Без затухания радиус бесконечен
+inline float pointLightRange(const PointLightDesc &light) {
+  glm::vec3 color = light.ambient + light.diffuse + light.specular;
+  float ratio = std::max({color.x, color.y, color.z}) / LIGHT_CUTOFF;
+  if (ratio <= 1.f)
+    return 0.f;
+  if (light.quadratic > 0.f)
+    return (-light.linear +
+            std::sqrt(light.linear * light.linear +
+                      4.f * light.quadratic * (ratio - 1.f))) /
+           (2.f * light.quadratic);
+  if (light.linear > 0.f)
+    return (ratio - 1.f) / light.linear;
+  return std::numeric_limits<float>::infinity();
+}
+
+// Формат источников в SSBO (std430)
+// ---------------------------------
+// Буфер: LightBufferHeader, затем массив источников
+struct LightBufferHeader {
+  std::uint32_t count;
+  std::uint32_t padding[3];
+};
+
+struct GpuPointLight {
+  glm::vec3 position;
+  float linear;
+  glm::vec3 ambient;
+  float quadratic;
+  glm::vec3 diffuse;
+  float range; // См. pointLightRange
+  glm::vec3 specular;
+  float padding;
+};
+
+struct GpuSpotLight {
+  glm::vec3 position;
+  float cutOff;
+  glm::vec3 direction;
+  float outerCutOff;
+  glm::vec3 ambient;
+  float linear;
+  glm::vec3 diffuse;
+  float quadratic;
+  glm::vec3 specular;
+  float padding;
+};
+
+struct GpuDirLight {
+  glm::vec3 direction;
+  float padding0;
+  glm::vec3 ambient;
+  float padding1;
+  glm::vec3 diffuse;
+  float padding2;
+  glm::vec3 specular;
+  float padding3;
+};
+
+static_assert(sizeof(LightBufferHeader) == 16 && sizeof(GpuPointLight) == 64 &&
+              sizeof(GpuSpotLight) == 80 && sizeof(GpuDirLight) == 64);
+
+// Хранение источников по полям (SoA)
+// ----------------------------------
+// Каждое поле - отдельный массив: обход одного поля (например, позиций при
+// распределении источников по пространству) читает память подряд.
+// В SSBO поля упаковываются в структуры std430 только для измененных
+// источников.
+namespace detail {
+
+struct PointLightSoA {
+  using Desc = PointLightDesc;
+  using Gpu = GpuPointLight;
+
+  std::vector<glm::vec3> position, ambient, diffuse, specular;
+  std::vector<float> linear, quadratic;
+  std::vector<float> range; // Вычисляется при записи
+
+  void resize(std::size_t size) {
+    position.resize(size);
+    ambient.resize(size);
+    diffuse.resize(size);
+    specular.resize(size);
+    linear.resize(size);
+    quadratic.resize(size);
+    range.resize(size);
+  }
+
+  void store(std::size_t i, const Desc &light) {
+    position[i] = light.position;
+    linear[i] = light.linear;
+    quadratic[i] = light.quadratic;
+    ambient[i] = light.ambient;
+    diffuse[i] = light.diffuse;
+    specular[i] = light.specular;
+    range[i] = pointLightRange(light);
+  }
+
+  Desc load(std::size_t i) const {
+    return {position[i], linear[i],  quadratic[i],
+            ambient[i],  diffuse[i], specular[i]};
+  }
+
+  Gpu pack(std::size_t i) const {
+    return {position[i], linear[i], ambient[i], quadratic[i],
+            diffuse[i],  range[i],  specular[i], 0.f};
+  }
+};
+
+struct SpotLightSoA {
+  using Desc = SpotLightDesc;
+  using Gpu = GpuSpotLight;
+
+  std::vector<glm::vec3> position, direction, ambient, diffuse, specular;
+  std::vector<float> cutOff, outerCutOff, linear, quadratic;
+
+  void resize(std::size_t size) {
+    position.resize(size);
+    direction.resize(size);
+    ambient.resize(size);
+    diffuse.resize(size);
+    specular.resize(size);
+    cutOff.resize(size);
+    outerCutOff.resize(size);
+    linear.resize(size);
+    quadratic.resize(size);
+  }
+
+  void store(std::size_t i, const Desc &light) {
+    position[i] = light.position;
+    direction[i] = light.direction;
+    cutOff[i] = light.cutOff;
+    outerCutOff[i] = light.outerCutOff;
+    linear[i] = light.linear;
+    quadratic[i] = light.quadratic;
+    ambient[i] = light.ambient;
+    diffuse[i] = light.diffuse;
+    specular[i] = light.specular;
+  }
+
+  Desc load(std::size_t i) const {
+    return {position[i], direction[i], cutOff[i],
+            outerCutOff[i], linear[i], quadratic[i],
+            ambient[i], diffuse[i], specular[i]};
+  }
+
+  Gpu pack(std::size_t i) const {
+    return {position[i], cutOff[i],    direction[i], outerCutOff[i],
+            ambient[i],  linear[i],    diffuse[i],   quadratic[i],
+            specular[i], 0.f};
+  }
+};
+
+struct DirLightSoA {
+  using Desc = DirLightDesc;
+  using Gpu = GpuDirLight;
+
+  std::vector<glm::vec3> direction, ambient, diffuse, specular;
+
+  void resize(std::size_t size) {
+    direction.resize(size);
+    ambient.resize(size);
+    diffuse.resize(size);
+    specular.resize(size);
+  }
+
+  void store(std::size_t i, const Desc &light) {
+    direction[i] = light.direction;
+    ambient[i] = light.ambient;
+    diffuse[i] = light.diffuse;
+    specular[i] = light.specular;
+  }
+
+  Desc load(std::size_t i) const {
+    return {direction[i], ambient[i], diffuse[i], specular[i]};
+  }
+
+  Gpu pack(std::size_t i) const {
+    return {direction[i], 0.f, ambient[i],  0.f,
+            diffuse[i],   0.f, specular[i], 0.f};
+  }
+};
+
+} // namespace detail
+
+// Список источников одного типа
+// -----------------------------
+// Источники лежат в SoA плотно; идентификатор, возвращаемый add(), остается
+// действительным до remove() (удаление переносит последний источник на
+// место удаленного). Изменения отмечают грязный диапазон индексов, и
+// upload() упаковывает и загружает только его. Буфер растет удвоением, так
+// что число источников ограничено только памятью.
+template <typename SoA> class LightList {
+public:
+  using Desc = typename SoA::Desc;
+  using Gpu = typename SoA::Gpu;
+  static constexpr std::uint32_t INVALID = ~0u;
+
+  // Добавление источника, возвращает его идентификатор
+  std::uint32_t add(const Desc &light) {
+    std::uint32_t id;
+    if (!freeIds.empty()) {
+      id = freeIds.back();
+      freeIds.pop_back();
+    } else {
+      id = static_cast<std::uint32_t>(idToIndex.size());
+      idToIndex.push_back(INVALID);
+    }
+    std::size_t index = indexToId.size();
+    idToIndex[id] = static_cast<std::uint32_t>(index);
+    indexToId.push_back(id);
+    soa.resize(index + 1);
+    soa.store(index, light);
+    markDirty(index);
+    countDirty = true;
+    return id;
+  }
+
+  // Изменение источника (грязным он становится, только если изменился)
+  void set(std::uint32_t id, const Desc &light) {
+    if (!valid(id))
+      return;
+    std::size_t index = idToIndex[id];
+    if (soa.load(index) == light)
+      return;
+    soa.store(index, light);
+    markDirty(index);
+  }
+
+  Desc get(std::uint32_t id) const {
+    return valid(id) ? soa.load(idToIndex[id]) : Desc{};
+  }
+
+  // Удаление источника
+  void remove(std::uint32_t id) {
+    if (!valid(id))
+      return;
+    std::size_t index = idToIndex[id], last = indexToId.size() - 1;
+    if (index != last) {
+      soa.store(index, soa.load(last));
+      indexToId[index] = indexToId[last];
+      idToIndex[indexToId[index]] = static_cast<std::uint32_t>(index);
+      markDirty(index);
+    }
+    indexToId.pop_back();
+    soa.resize(last);
+    idToIndex[id] = INVALID;
+    freeIds.push_back(id);
+    countDirty = true;
+  }
+
+  bool valid(std::uint32_t id) const {
+    return id < idToIndex.size() && idToIndex[id] != INVALID;
+  }
+
+  std::size_t size() const { return indexToId.size(); }
+  // Поля источников (в порядке индексов)
+  const SoA &data() const { return soa; }
+
+  // Загрузка грязного диапазона и привязка буфера
+  void upload(GLuint binding) {
+    std::size_t count = size();
+    if (!buffer || count > capacity) {
+      GLState::instance().deleteBuffers(1, &buffer);
+      capacity = std::max<std::size_t>({count, capacity * 2, 16});
+      glCreateBuffers(1, &buffer);
+      glNamedBufferStorage(
+          buffer,
+          static_cast<GLsizeiptr>(sizeof(LightBufferHeader) +
+                                  capacity * sizeof(Gpu)),
+          nullptr, GL_DYNAMIC_STORAGE_BIT);
+      // Новый буфер пуст - загружаются все источники
+      dirtyBegin = 0;
+      dirtyEnd = count;
+      countDirty = true;
+    }
+
+    if (countDirty) {
+      LightBufferHeader header = {static_cast<std::uint32_t>(count), {}};
+      glNamedBufferSubData(buffer, 0, sizeof(header), &header);
+      countDirty = false;
+    }
+    dirtyEnd = std::min(dirtyEnd, count);
+    if (dirtyBegin < dirtyEnd) {
+      staging.resize(dirtyEnd - dirtyBegin);
+      for (std::size_t i = dirtyBegin; i < dirtyEnd; i++)
+        staging[i - dirtyBegin] = soa.pack(i);
+      glNamedBufferSubData(
+          buffer,
+          static_cast<GLintptr>(sizeof(LightBufferHeader) +
+                                dirtyBegin * sizeof(Gpu)),
+          static_cast<GLsizeiptr>(staging.size() * sizeof(Gpu)),
+          staging.data());
+    }
+    dirtyBegin = std::numeric_limits<std::size_t>::max();
+    dirtyEnd = 0;
+
+    GLState::instance().bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding,
+                                       buffer);
+  }
+
+  // Удаление буфера (до уничтожения контекста)
+  void release() {
+    GLState::instance().deleteBuffers(1, &buffer);
+    buffer = 0;
+    capacity = 0;
+  }
+
+private:
+  SoA soa;
+  std::vector<std::uint32_t> idToIndex; // Идентификатор -> индекс
+  std::vector<std::uint32_t> indexToId; // Индекс -> идентификатор
+  std::vector<std::uint32_t> freeIds;
+  std::vector<Gpu> staging;
+  std::size_t dirtyBegin = std::numeric_limits<std::size_t>::max();
+  std::size_t dirtyEnd = 0;
+  bool countDirty = true;
+  unsigned int buffer = 0;
+  std::size_t capacity = 0; // Источников
+
+  void markDirty(std::size_t index) {
+    dirtyBegin = std::min(dirtyBegin, index);
+    dirtyEnd = std::max(dirtyEnd, index + 1);
+  }
+};
+
+// Менеджер источников света
+// -------------------------
+// Точечные источники, прожекторы и направленный свет в отдельных SSBO
+// (POINT_LIGHT_BINDING, SPOT_LIGHT_BINDING, DIR_LIGHT_BINDING). Источники
+// меняются через списки в любой момент кадра; upload() перед отрисовкой
+// загружает изменения и привязывает буферы.
+class LightManager {
+public:
+  LightList<detail::PointLightSoA> points;
+  LightList<detail::SpotLightSoA> spots;
+  LightList<detail::DirLightSoA> directional;
+
+  // Загрузка изменений и привязка буферов
+  void upload() {
+    points.upload(POINT_LIGHT_BINDING);
+    spots.upload(SPOT_LIGHT_BINDING);
+    directional.upload(DIR_LIGHT_BINDING);
+  }
+
+  // Удаление буферов (до уничтожения контекста)
+  void release() {
+    points.release();
+    spots.release();
+    directional.release();
+  }
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// Остальные библиотеки
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Файл, отображенный в память только для чтения
+// ---------------------------------------------
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path) { open(path); }
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept
+      : mData(std::exchange(other.mData, nullptr)),
+        mSize(std::exchange(other.mSize, 0)) {}
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      close();
+      mData = std::exchange(other.mData, nullptr);
+      mSize = std::exchange(other.mSize, 0);
+    }
+    return *this;
+  }
+
+  // Открытие файла (false, если файла нет или он пуст)
+  bool open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *ptr = mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                       PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr != MAP_FAILED) {
+        mData = static_cast<const std::byte *>(ptr);
+        mSize = static_cast<std::size_t>(st.st_size);
+      }
+    }
+    // Отображение остается валидным после закрытия дескриптора
+    ::close(fd);
+    return mData != nullptr;
+  }
+
+  // Закрытие отображения
+  void close() {
+    if (mData)
+      munmap(const_cast<std::byte *>(mData), mSize);
+    mData = nullptr;
+    mSize = 0;
+  }
+
+  const std::byte *data() const { return mData; }
+  std::size_t size() const { return mSize; }
+  bool isOpen() const { return mData != nullptr; }
+
+private:
+  const std::byte *mData = nullptr;
+  std::size_t mSize = 0;
+};
+
+// Уникальное имя временного файла рядом с path: файл пишется под этим
+// именем и переименовывается в path (rename атомарен), поэтому процессы и
+// потоки, одновременно пишущие один файл, не портят данные друг друга
+inline std::string temporaryPath(const std::string &path) {
+  static std::atomic<unsigned long> counter = 0;
+  return path + '.' + std::to_string(static_cast<long>(getpid())) + '.' +
+         std::to_string(counter++) + ".tmp";
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные библиотеки
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "GLState.h"         // Кеш состояния OpenGL
+#include "TextureStreamer.h" // Асинхронная загрузка текстур
+
+// Точка привязки SSBO параметров материалов (см. lightFragmentShader.glsl)
+constexpr GLuint MATERIAL_BINDING = 7;
+
+/* Текстура */
+struct Texture {
+  unsigned int id;
+  std::string type;
+  std::string path;
+};
+
+// Текстурные блоки материала (layout (binding = N) в шейдерах)
+enum MaterialSlot : unsigned int {
+  MATERIAL_DIFFUSE = 0,  // texture_diffuse
+  MATERIAL_SPECULAR = 1, // texture_specular
+  MATERIAL_NORMAL = 2,   // texture_normal
+  MATERIAL_HEIGHT = 3,   // texture_height
+  MATERIAL_SLOTS = 4
+};
+
+// Параметры материала в SSBO (std430)
+struct GpuMaterial {
+  float shininess;
+};
+static_assert(sizeof(GpuMaterial) == 4);
+
+// Таблица привязки материала
+// --------------------------
+// Строится один раз при загрузке меша: текстура каждого типа получает свой
+// блок, параметры - индекс в таблице материалов. При отрисовке bind()
+// привязывает все блоки одним вызовом без строк и поиска uniform-
+// переменных; индекс передается в шейдер как baseInstance команды
+// отрисовки (gl_BaseInstance). Одинаковые наборы текстур получают один
+// номер textureSet (ключ сортировки очереди отрисовки, см. RenderQueue.h).
+struct MaterialBinding {
+  std::array<unsigned int, MATERIAL_SLOTS> textures = {};
+  std::uint32_t index = 0;
+  std::uint32_t textureSet = 0;
+
+  // Привязка текстур к блокам 0..MATERIAL_SLOTS-1 (пока текстура
+  // загружается, привязывается заглушка)
+  void bind() const {
+    GLuint names[MATERIAL_SLOTS];
+    for (unsigned int slot = 0; slot < MATERIAL_SLOTS; slot++)
+      names[slot] = textures[slot]
+                        ? TextureStreamer::instance().resolve(textures[slot])
+                        : 0;
+    GLState::instance().bindTextures(0, MATERIAL_SLOTS, names);
+  }
+};
+
+// Таблица материалов
+// ------------------
+// Параметры всех материалов в одном SSBO (MATERIAL_BINDING). Одинаковые
+// параметры используют одну запись, поэтому таблица растет только с
+// числом различных материалов.
+class MaterialTable {
+public:
+  // Глобальный экземпляр
+  static MaterialTable &instance() {
+    static MaterialTable table;
+    return table;
+  }
+
+  // Таблица привязки для набора текстур меша (используется первая
+  // текстура каждого типа)
+  MaterialBinding create(const std::vector<Texture> &textures,
+                         float shininess) {
+    MaterialBinding binding;
+    for (const Texture &texture : textures) {
+      unsigned int slot = slotOf(texture.type);
+      if (slot < MATERIAL_SLOTS && !binding.textures[slot])
+        binding.textures[slot] = texture.id;
+    }
+    binding.index = add({shininess});
+    binding.textureSet = textureSetOf(binding.textures);
+    return binding;
+  }
+
+  // Загрузка изменений и привязка SSBO (раз в кадр перед отрисовкой)
+  void bind() {
+    if (dirty) {
+      if (capacity < materials.size()) {
+        GLState::instance().deleteBuffers(1, &buffer);
+        glCreateBuffers(1, &buffer);
+        capacity = materials.capacity();
+        glNamedBufferStorage(buffer, capacity * sizeof(GpuMaterial), nullptr,
+                             GL_DYNAMIC_STORAGE_BIT);
+      }
+      glNamedBufferSubData(buffer, 0, materials.size() * sizeof(GpuMaterial),
+                           materials.data());
+      dirty = false;
+    }
+    GLState::instance().bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+                                       MATERIAL_BINDING, buffer);
+  }
+
+  // Число материалов
+  std::size_t size() const { return materials.size(); }
+
+  // Удаление буфера (до уничтожения контекста)
+  void shutdown() {
+    GLState::instance().deleteBuffers(1, &buffer);
+    buffer = 0;
+    capacity = 0;
+    materials.clear();
+    textureSets.clear();
+    dirty = false;
+  }
+
+private:
+  std::vector<GpuMaterial> materials;
+  std::vector<std::array<unsigned int, MATERIAL_SLOTS>> textureSets;
+  unsigned int buffer = 0;
+  std::size_t capacity = 0;
+  bool dirty = false;
+
+  MaterialTable() = default;
+
+  // Блок текстуры по типу
+  static unsigned int slotOf(const std::string &type) {
+    if (type == "texture_diffuse")
+      return MATERIAL_DIFFUSE;
+    if (type == "texture_specular")
+      return MATERIAL_SPECULAR;
+    if (type == "texture_normal")
+      return MATERIAL_NORMAL;
+    if (type == "texture_height")
+      return MATERIAL_HEIGHT;
+    return MATERIAL_SLOTS;
+  }
+
+  // Индекс записи с такими параметрами (новая запись, если ее нет)
+  std::uint32_t add(const GpuMaterial &material) {
+    for (std::size_t i = 0; i < materials.size(); i++)
+      if (materials[i].shininess == material.shininess)
+        return static_cast<std::uint32_t>(i);
+    materials.push_back(material);
+    dirty = true;
+    return static_cast<std::uint32_t>(materials.size() - 1);
+  }
+
+  // Номер набора текстур (новый номер, если такого набора еще нет)
+  std::uint32_t
+  textureSetOf(const std::array<unsigned int, MATERIAL_SLOTS> &textures) {
+    auto it = std::find(textureSets.begin(), textureSets.end(), textures);
+    if (it != textureSets.end())
+      return static_cast<std::uint32_t>(it - textureSets.begin());
+    textureSets.push_back(textures);
+    return static_cast<std::uint32_t>(textureSets.size() - 1);
+  }
+};
+
+#endif
@@ -7,184 +7,141 @@
 #include <glm/glm.hpp>
 
 // Остальные библиотеки
+#include <algorithm>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <utility>
+#include <variant>
 #include <vector>
 
 // Остальные заголовочные файлы
-#include "Shader.h" // Класс шейдера
-
-#define MAX_BONE_INFLUENCE 4
-
-// Структуры данных
-// ----------------
-/* Вершина */
-struct Vertex {
-  glm::vec3 Position;
-  glm::vec3 Normal;
-  glm::vec2 TexCoords;
-  glm::vec3 Tangent;
-  glm::vec3 Bitangent;
-  // bone indexes which will influence this vertex
-  int m_BoneIDs[MAX_BONE_INFLUENCE];
-  // weights from each bone
-  float m_Weights[MAX_BONE_INFLUENCE];
-};
-
-/* Текстура */
-struct Texture {
-  unsigned int id;
-  std::string type;
-  std::string path;
-};
+#include "GeometryHeap.h"   // Куча геометрии
+#include "GLState.h"        // Кеш состояния OpenGL
+#include "Material.h"       // Текстуры и таблицы привязки материалов
+#include "Shader.h"         // Класс шейдера
+#include "ShaderVariants.h" // Возможности вариантов шейдера
+#include "VertexFormats.h"  // Форматы вершин
 
 // Класс Mesh
 // ----------
-class Mesh {
+// Шаблон по формату вершины. Вершины и индексы лежат в общей куче геометрии
+// (см. GeometryHeap.h): все меши одного формата используют один VAO, а меш
+// хранит только описатель своего диапазона. При splitPositions позиции
+// хранятся в отдельном плотном потоке (binding 0, 8 байт на вершину), а
+// остальные атрибуты - во втором потоке (binding 1); иначе вершины
+// чередуются в одном буфере. В обоих случаях DrawDepth читает только
+// позиции для проходов глубины, теней и выбора объектов. Материал
+// разрешается в таблицу привязки (Material.h) при создании меша.
+template <typename VertexT> class Mesh {
 public:
   // Данные
-  std::vector<Vertex> vertices;
-  std::vector<unsigned int> indices;
   std::vector<Texture> textures;
   float matShininess;
-  unsigned int VAO;
+  VertexQuantization quantization;
+  unsigned int indexCount;
+  GeometryHandle geometry;
+  // Возможности материала для выбора варианта шейдера
+  // (SHADER_SPECULAR_MAP, SHADER_NORMAL_MAP)
+  std::uint32_t materialFeatures = 0;
+  // Текстурные блоки и индекс параметров материала
+  MaterialBinding material;
 
   // Конструктор
-  Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-       std::vector<Texture> textures, float matShininess) {
-    this->vertices = vertices;
-    this->indices = indices;
-    this->textures = textures;
+  // Вершины и индексы сразу загружаются в GPU и на CPU не хранятся, поэтому
+  // данные могут указывать на временный буфер или отображенный в память файл
+  Mesh(std::span<const VertexT> vertices, std::span<const unsigned int> indices,
+       std::vector<Texture> textures, float matShininess,
+       const VertexQuantization &quantization, bool splitPositions = false) {
+    this->textures = std::move(textures);
     this->matShininess = matShininess;
+    this->quantization = quantization;
+    this->indexCount = static_cast<unsigned int>(indices.size());
+
+    // Карта нормалей используется, только если в формате есть касательная
+    constexpr bool hasTangent = std::ranges::any_of(
+        VertexFormat<VertexT>::attributes,
+        [](const VertexAttribute &attribute) {
+          return attribute.location == 3;
+        });
+    for (const Texture &texture : this->textures) {
+      if (texture.type == "texture_specular")
+        materialFeatures |= SHADER_SPECULAR_MAP;
+      else if (texture.type == "texture_normal" && hasTangent)
+        materialFeatures |= SHADER_NORMAL_MAP;
+    }
+    material = MaterialTable::instance().create(this->textures, matShininess);
 
-    setupMesh();
+    geometry = GeometryHeap::instance().allocate<VertexT>(vertices, indices,
+                                                          splitPositions);
+  }
+  // Меш рисуется с набором материала filter (ANY_MATERIAL - любой материал)
+  bool matches(std::uint32_t filter) const {
+    return filter == ANY_MATERIAL || filter == materialFeatures;
   }
+
   // Отрисовка
-  void Draw(Shader &shader) {
-    unsigned int diffuseNr = 0;
-    unsigned int specularNr = 0;
-    unsigned int normalNr = 0;
-    unsigned int heightNr = 0;
-
-    shader.setFloat("material.shininess", matShininess);
-
-    // Текстурные карты
-    for (unsigned int i = 0; i < textures.size(); i++) {
-      std::string number;
-      std::string name = textures[i].type;
-      if (name == "texture_diffuse")
-        number = std::to_string(++diffuseNr);
-      else if (name == "texture_specular")
-        number = std::to_string(++specularNr);
-      else if (name == "texture_normal")
-        number = std::to_string(++normalNr);
-      else if (name == "texture_height")
-        number = std::to_string(++heightNr);
-
-      shader.setInt(("material." + name + number).c_str(), (int)i);
-      glBindTextureUnit(i, textures[i].id);
-    }
+  void Draw(Shader &shader) const {
+    material.bind();
+    setQuantization(shader);
+
+    GeometryRange range = GeometryHeap::instance().range(geometry);
+    drawRange(range.vao, range, 1, material.index);
+  }
 
-    // Привязка VAO к текущему контексту
-    glBindVertexArray(VAO);
-    // Отрисовка элементов
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()),
-                   GL_UNSIGNED_INT, 0);
-    // Отвязка VAO от текущего контекста
-    glBindVertexArray(0);
+  // Отрисовка instanceCount экземпляров (трансформации - в SSBO, см.
+  // InstanceBuffer.h)
+  void DrawInstanced(Shader &shader, GLsizei instanceCount) const {
+    material.bind();
+    setQuantization(shader);
+
+    GeometryRange range = GeometryHeap::instance().range(geometry);
+    drawRange(range.vao, range, instanceCount, material.index);
+  }
+
+  // Отрисовка только позиций (без материала и текстур)
+  void DrawDepth(Shader &shader, GLsizei instanceCount = 1) const {
+    setQuantization(shader);
+
+    GeometryRange range = GeometryHeap::instance().range(geometry);
+    drawRange(range.depthVAO, range, instanceCount);
+  }
+
+  // Освобождение геометрии в куче
+  void release() {
+    GeometryHeap::instance().free(geometry);
+    geometry = {};
   }
 
 private:
-  // Данные рендера
-  unsigned int VBO, EBO;
-
-  void setupMesh() {
-    // Создание имен VAO, VBO и EBO
-    // ----------------------------
-    glCreateVertexArrays(1, &VAO);
-    glCreateBuffers(1, &VBO);
-    glCreateBuffers(1, &EBO);
-
-    // Заполнение буферов данными
-    // --------------------------
-    // VBO
-    glNamedBufferStorage(VBO, vertices.size() * sizeof(Vertex), &vertices[0],
-                         0);
-    // EBO
-    glNamedBufferStorage(EBO, indices.size() * sizeof(unsigned int),
-                         &indices[0], 0);
-
-    // Атрибуты вершин
-    // ---------------
-    /* Позиции */
-    // Формат
-    glVertexArrayAttribFormat(VAO, 0, 3, GL_FLOAT, GL_FALSE,
-                              offsetof(Vertex, Position));
-    // Прикрепление атрибута к VAO
-    glVertexArrayAttribBinding(VAO, 0, 0);
-    // Включение
-    glEnableVertexArrayAttrib(VAO, 0);
-
-    /* Нормали */
-    // Формат
-    glVertexArrayAttribFormat(VAO, 1, 3, GL_FLOAT, GL_FALSE,
-                              offsetof(Vertex, Normal));
-    // Прикрепление атрибута к VAO
-    glVertexArrayAttribBinding(VAO, 1, 0);
-    // Включение
-    glEnableVertexArrayAttrib(VAO, 1);
-
-    /* Текстурные координаты */
-    // Формат
-    glVertexArrayAttribFormat(VAO, 2, 2, GL_FLOAT, GL_FALSE,
-                              offsetof(Vertex, TexCoords));
-    // Прикрепление атрибута к VAO
-    glVertexArrayAttribBinding(VAO, 2, 0);
-    // Включение
-    glEnableVertexArrayAttrib(VAO, 2);
-
-    /* Tangent */
-    // Формат
-    glVertexArrayAttribFormat(VAO, 3, 3, GL_FLOAT, GL_FALSE,
-                              offsetof(Vertex, Tangent));
-    // Прикрепление атрибута к VAO
-    glVertexArrayAttribBinding(VAO, 3, 0);
-    // Включение
-    glEnableVertexArrayAttrib(VAO, 3);
-
-    /* Bitangent */
-    // Формат
-    glVertexArrayAttribFormat(VAO, 4, 3, GL_FLOAT, GL_FALSE,
-                              offsetof(Vertex, Bitangent));
-    // Прикрепление атрибута к VAO
-    glVertexArrayAttribBinding(VAO, 4, 0);
-    // Включение
-    glEnableVertexArrayAttrib(VAO, 4);
-
-    /* ids */
-    // Формат
-    glVertexArrayAttribFormat(VAO, 5, 4, GL_INT, GL_FALSE,
-                              offsetof(Vertex, m_BoneIDs));
-    // Прикрепление атрибута к VAO
-    glVertexArrayAttribBinding(VAO, 5, 0);
-    // Включение
-    glEnableVertexArrayAttrib(VAO, 5);
-
-    /* ids */
-    // Формат
-    glVertexArrayAttribFormat(VAO, 6, 4, GL_FLOAT, GL_FALSE,
-                              offsetof(Vertex, m_Weights));
-    // Прикрепление атрибута к VAO
-    glVertexArrayAttribBinding(VAO, 6, 0);
-    // Включение
-    glEnableVertexArrayAttrib(VAO, 6);
-
-    // Прикрепление буферов VAO
-    // ------------------------
-    // VBO
-    glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(Vertex));
-    // EBO
-    glVertexArrayElementBuffer(VAO, EBO);
+  // Параметры деквантования позиций (posOffset + aPos * posScale)
+  void setQuantization(const Shader &shader) const {
+    const Shader::DrawUniforms &uniforms = shader.drawUniforms();
+    uniforms.posOffset.set(quantization.offset);
+    uniforms.posScale.set(quantization.scale);
+  }
+
+  // Отрисовка диапазона кучи. VAO пула не отвязывается: следующий меш того
+  // же формата использует тот же VAO. baseInstance - индекс материала
+  // (атрибутов с делителем нет, поэтому он влияет только на
+  // gl_BaseInstance)
+  static void drawRange(unsigned int vao, const GeometryRange &range,
+                        GLsizei instanceCount = 1,
+                        std::uint32_t baseInstance = 0) {
+    if (!vao || instanceCount <= 0)
+      return;
+    GLState::instance().bindVertexArray(vao);
+    glDrawElementsInstancedBaseVertexBaseInstance(
+        GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+        reinterpret_cast<const void *>(std::uintptr_t(range.firstIndex) *
+                                       sizeof(unsigned int)),
+        instanceCount, range.baseVertex, baseInstance);
   }
 };
 
+// Меш любого формата (модель хранит меши разных форматов в одном массиве)
+using AnyMesh = std::variant<Mesh<VertexPosition>, Mesh<VertexUnlit>,
+                             Mesh<VertexLit>, Mesh<VertexNormalMapped>,
+                             Mesh<VertexSkinned>>;
+
 #endif
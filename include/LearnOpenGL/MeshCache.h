@@ -0,0 +1,312 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+// Остальные библиотеки
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "Hash.h"       // Хеширование
+#include "MappedFile.h" // Отображение файла в память
+#include "Mesh.h"       // Вершины и текстуры
+
+// Бинарный кеш импортированной модели
+// -----------------------------------
+// Файл лежит рядом с исходным ассетом (<path>.meshcache) и содержит готовые
+// к загрузке в GPU массивы сжатых вершин (формат выбирается для каждого меша,
+// см. VertexFormats.h) и индексов, таблицу материалов и ссылки на
+// текстуры. Кеш действителен, пока совпадают хеш исходного файла, флаги
+// импорта Assimp, дополнительные этапы импорта и версия формата.
+//
+// Структура файла:
+//   Header
+//   Record[meshCount]
+//   TextureRef[textureCount]
+//   блоки вершин и индексов (выровнены по ALIGNMENT)
+//   таблица строк (типы и пути текстур)
+namespace MeshCache {
+
+constexpr char MAGIC[4] = {'L', 'G', 'M', 'C'};
+// Версия формата: увеличивать при любом изменении формата вершин или
+// структуры файла
+constexpr std::uint32_t VERSION = 4;
+constexpr std::uint64_t ALIGNMENT = 16;
+
+// Заголовок файла
+struct Header {
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t sourceHash;
+  std::uint32_t importFlags;
+  std::uint32_t importOptions;
+  std::uint32_t meshCount;
+  std::uint32_t textureCount;
+  std::uint64_t stringTableOffset;
+  std::uint64_t stringTableSize;
+};
+
+// Описание одного меша
+struct Record {
+  std::uint64_t vertexOffset;
+  std::uint64_t indexOffset;
+  std::uint32_t vertexCount;
+  std::uint32_t indexCount;
+  std::uint32_t firstTexture;
+  std::uint32_t textureCount;
+  float shininess;
+  float positionOffset[3];
+  float positionScale[3];
+  VertexFormatId vertexFormat;
+};
+
+// Ссылка на текстуру (смещения в таблице строк)
+struct TextureRef {
+  std::uint32_t typeOffset;
+  std::uint32_t typeLength;
+  std::uint32_t pathOffset;
+  std::uint32_t pathLength;
+};
+
+// Данные меша для записи в кеш
+struct MeshEntry {
+  VertexFormatId vertexFormat;
+  std::span<const std::byte> vertices;
+  std::span<const unsigned int> indices;
+  const std::vector<Texture> *textures;
+  float shininess;
+  VertexQuantization quantization;
+};
+
+// Путь к файлу кеша для ассета
+inline std::string cachePath(const std::string &sourcePath) {
+  return sourcePath + ".meshcache";
+}
+
+// Чтение кеша
+// -----------
+class Reader {
+public:
+  // Открытие и проверка кеша (false, если кеш отсутствует или устарел)
+  bool open(const std::string &path, std::uint64_t sourceHash,
+            std::uint32_t importFlags, std::uint32_t importOptions) {
+    if (!file.open(path))
+      return false;
+    if (!validate(sourceHash, importFlags, importOptions)) {
+      file.close();
+      return false;
+    }
+    return true;
+  }
+
+  std::size_t meshCount() const { return header().meshCount; }
+
+  VertexFormatId vertexFormat(std::size_t mesh) const {
+    return records()[mesh].vertexFormat;
+  }
+
+  // Вершины меша в формате vertexFormat(mesh)
+  std::span<const std::byte> vertices(std::size_t mesh) const {
+    const Record &r = records()[mesh];
+    return {reinterpret_cast<const std::byte *>(file.data() + r.vertexOffset),
+            r.vertexCount * vertexSize(r.vertexFormat)};
+  }
+
+  std::span<const unsigned int> indices(std::size_t mesh) const {
+    const Record &r = records()[mesh];
+    return {
+        reinterpret_cast<const unsigned int *>(file.data() + r.indexOffset),
+        r.indexCount};
+  }
+
+  float shininess(std::size_t mesh) const { return records()[mesh].shininess; }
+
+  VertexQuantization quantization(std::size_t mesh) const {
+    const Record &r = records()[mesh];
+    return {glm::vec3(r.positionOffset[0], r.positionOffset[1],
+                      r.positionOffset[2]),
+            glm::vec3(r.positionScale[0], r.positionScale[1],
+                      r.positionScale[2])};
+  }
+
+  std::span<const TextureRef> textures(std::size_t mesh) const {
+    const Record &r = records()[mesh];
+    return {textureRefs() + r.firstTexture, r.textureCount};
+  }
+
+  std::string_view string(std::uint32_t offset, std::uint32_t length) const {
+    const char *table = reinterpret_cast<const char *>(
+        file.data() + header().stringTableOffset);
+    return {table + offset, length};
+  }
+
+private:
+  MappedFile file;
+
+  const Header &header() const {
+    return *reinterpret_cast<const Header *>(file.data());
+  }
+  const Record *records() const {
+    return reinterpret_cast<const Record *>(file.data() + sizeof(Header));
+  }
+  const TextureRef *textureRefs() const {
+    return reinterpret_cast<const TextureRef *>(
+        file.data() + sizeof(Header) + header().meshCount * sizeof(Record));
+  }
+
+  // Проверка заголовка и границ всех блоков
+  bool validate(std::uint64_t sourceHash, std::uint32_t importFlags,
+                std::uint32_t importOptions) const {
+    std::uint64_t size = file.size();
+    if (size < sizeof(Header))
+      return false;
+    const Header &h = header();
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        h.version != VERSION ||
+        h.sourceHash != sourceHash || h.importFlags != importFlags ||
+        h.importOptions != importOptions)
+      return false;
+
+    std::uint64_t tablesEnd =
+        sizeof(Header) + std::uint64_t(h.meshCount) * sizeof(Record) +
+        std::uint64_t(h.textureCount) * sizeof(TextureRef);
+    if (tablesEnd > size || h.stringTableOffset > size ||
+        h.stringTableSize > size - h.stringTableOffset)
+      return false;
+
+    for (std::uint32_t i = 0; i < h.meshCount; i++) {
+      const Record &r = records()[i];
+      if (r.vertexFormat > VertexFormatId::Skinned ||
+          r.vertexOffset % ALIGNMENT || r.indexOffset % ALIGNMENT ||
+          r.vertexOffset + std::uint64_t(r.vertexCount) *
+                               vertexSize(r.vertexFormat) >
+              size ||
+          r.indexOffset + std::uint64_t(r.indexCount) * sizeof(unsigned int) >
+              size ||
+          std::uint64_t(r.firstTexture) + r.textureCount > h.textureCount)
+        return false;
+    }
+    for (std::uint32_t i = 0; i < h.textureCount; i++) {
+      const TextureRef &t = textureRefs()[i];
+      if (std::uint64_t(t.typeOffset) + t.typeLength > h.stringTableSize ||
+          std::uint64_t(t.pathOffset) + t.pathLength > h.stringTableSize)
+        return false;
+    }
+    return true;
+  }
+};
+
+// Запись кеша
+// -----------
+// Файл пишется во временный и затем атомарно переименовывается, чтобы
+// параллельно запущенный процесс не прочитал его наполовину записанным
+inline bool write(const std::string &path, std::uint64_t sourceHash,
+                  std::uint32_t importFlags, std::uint32_t importOptions,
+                  const std::vector<MeshEntry> &meshes) {
+  auto align = [](std::uint64_t offset) {
+    return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  };
+
+  Header header = {};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.sourceHash = sourceHash;
+  header.importFlags = importFlags;
+  header.importOptions = importOptions;
+  header.meshCount = static_cast<std::uint32_t>(meshes.size());
+
+  // Таблица текстур и строк
+  std::vector<TextureRef> textureRefs;
+  std::string strings;
+  auto addString = [&strings](const std::string &str) {
+    std::uint32_t offset = static_cast<std::uint32_t>(strings.size());
+    strings += str;
+    return offset;
+  };
+
+  // Раскладка блоков данных
+  std::vector<Record> records(meshes.size());
+  std::uint64_t offset = sizeof(Header) + meshes.size() * sizeof(Record);
+  for (std::size_t i = 0; i < meshes.size(); i++) {
+    records[i].firstTexture = static_cast<std::uint32_t>(textureRefs.size());
+    records[i].textureCount =
+        static_cast<std::uint32_t>(meshes[i].textures->size());
+    for (const Texture &texture : *meshes[i].textures) {
+      TextureRef ref;
+      ref.typeLength = static_cast<std::uint32_t>(texture.type.size());
+      ref.typeOffset = addString(texture.type);
+      ref.pathLength = static_cast<std::uint32_t>(texture.path.size());
+      ref.pathOffset = addString(texture.path);
+      textureRefs.push_back(ref);
+    }
+  }
+  header.textureCount = static_cast<std::uint32_t>(textureRefs.size());
+  offset += textureRefs.size() * sizeof(TextureRef);
+
+  for (std::size_t i = 0; i < meshes.size(); i++) {
+    records[i].vertexFormat = meshes[i].vertexFormat;
+    records[i].vertexCount = static_cast<std::uint32_t>(
+        meshes[i].vertices.size() / vertexSize(meshes[i].vertexFormat));
+    records[i].indexCount =
+        static_cast<std::uint32_t>(meshes[i].indices.size());
+    records[i].shininess = meshes[i].shininess;
+    for (int c = 0; c < 3; c++) {
+      records[i].positionOffset[c] = meshes[i].quantization.offset[c];
+      records[i].positionScale[c] = meshes[i].quantization.scale[c];
+    }
+    records[i].vertexOffset = offset = align(offset);
+    offset += meshes[i].vertices.size_bytes();
+    records[i].indexOffset = offset = align(offset);
+    offset += meshes[i].indices.size_bytes();
+  }
+  header.stringTableOffset = offset;
+  header.stringTableSize = strings.size();
+
+  // Запись
+  std::string tmpPath = temporaryPath(path);
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+      return false;
+    auto put = [&out](const void *data, std::size_t size) {
+      out.write(static_cast<const char *>(data),
+                static_cast<std::streamsize>(size));
+    };
+    auto pad = [&out, &align]() {
+      std::uint64_t pos = static_cast<std::uint64_t>(out.tellp());
+      static const char zeros[ALIGNMENT] = {};
+      out.write(zeros, static_cast<std::streamsize>(align(pos) - pos));
+    };
+
+    put(&header, sizeof(header));
+    put(records.data(), records.size() * sizeof(Record));
+    put(textureRefs.data(), textureRefs.size() * sizeof(TextureRef));
+    for (const MeshEntry &mesh : meshes) {
+      pad();
+      put(mesh.vertices.data(), mesh.vertices.size_bytes());
+      pad();
+      put(mesh.indices.data(), mesh.indices.size_bytes());
+    }
+    put(strings.data(), strings.size());
+    if (!out) {
+      out.close();
+      std::remove(tmpPath.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace MeshCache
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+// Оптимизация индексных буферов
+// -----------------------------
+// Проходы выполняются в порядке:
+//   1. optimizeVertexCache - порядок треугольников под кеш вершин (Tipsify);
+//   2. optimizeOverdraw - порядок кластеров треугольников против перерисовки;
+//   3. optimizeVertexFetch - порядок вершин по первому использованию.
+// Все функции работают только с памятью и вызываются с рабочих потоков.
+namespace MeshOptimizer {
+
+// Размер моделируемого FIFO-кеша вершин
+constexpr unsigned int CACHE_SIZE = 16;
+
+// Статистика кеша вершин
+// ACMR - промахи на треугольник (0.5 - идеал для регулярной сетки, 3 -
+// худший случай), ATVR - промахи на вершину (1 - идеал)
+struct CacheStats {
+  float acmr = 0.f;
+  float atvr = 0.f;
+};
+
+// Моделирование FIFO-кеша вершин
+inline CacheStats analyzeVertexCache(std::span<const unsigned int> indices,
+                                     std::size_t vertexCount,
+                                     unsigned int cacheSize = CACHE_SIZE) {
+  CacheStats stats;
+  if (indices.empty())
+    return stats;
+
+  // Вершина в кеше, если с момента ее загрузки было меньше cacheSize промахов
+  std::vector<std::size_t> loadTime(vertexCount, 0);
+  std::vector<bool> used(vertexCount, false);
+  std::size_t time = cacheSize + 1;
+  std::size_t misses = 0, unique = 0;
+  for (unsigned int index : indices) {
+    if (!used[index]) {
+      used[index] = true;
+      unique++;
+    }
+    if (time - loadTime[index] > cacheSize) {
+      loadTime[index] = time++;
+      misses++;
+    }
+  }
+  stats.acmr = float(misses) / float(indices.size() / 3);
+  stats.atvr = float(misses) / float(unique);
+  return stats;
+}
+
+// Порядок треугольников под кеш вершин (Tipsify)
+// ----------------------------------------------
+// Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw" (2007). Треугольники выдаются веерами вокруг текущей
+// вершины; следующая вершина выбирается среди недавно использованных так,
+// чтобы ее веер еще попадал в кеш. В clusters записываются номера первых
+// треугольников участков, начатых после тупика (границы для overdraw).
+inline std::vector<unsigned int>
+optimizeVertexCache(std::span<const unsigned int> indices,
+                    std::size_t vertexCount,
+                    std::vector<std::size_t> *clusters = nullptr,
+                    unsigned int cacheSize = CACHE_SIZE) {
+  std::size_t triangleCount = indices.size() / 3;
+  std::vector<unsigned int> result;
+  result.reserve(triangleCount * 3);
+  if (clusters)
+    clusters->clear();
+  if (triangleCount == 0)
+    return result;
+
+  // Смежность вершина -> треугольники
+  std::vector<unsigned int> live(vertexCount, 0);
+  for (std::size_t i = 0; i < triangleCount * 3; i++)
+    live[indices[i]]++;
+  std::vector<std::size_t> firstTriangle(vertexCount + 1, 0);
+  for (std::size_t v = 0; v < vertexCount; v++)
+    firstTriangle[v + 1] = firstTriangle[v] + live[v];
+  std::vector<std::size_t> adjacency(firstTriangle[vertexCount]);
+  {
+    std::vector<std::size_t> fill(firstTriangle.begin(),
+                                  firstTriangle.end() - 1);
+    for (std::size_t i = 0; i < triangleCount * 3; i++)
+      adjacency[fill[indices[i]]++] = i / 3;
+  }
+
+  std::vector<std::size_t> cacheTime(vertexCount, 0);
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<unsigned int> deadEnd; // Стек недавно использованных вершин
+  std::vector<unsigned int> candidates;
+  std::size_t time = cacheSize + 1;
+  std::size_t cursor = 0; // Позиция последовательного поиска вершины
+
+  // Вершина после тупика: из стека, иначе первая с живыми треугольниками
+  auto skipDeadEnd = [&]() -> std::ptrdiff_t {
+    while (!deadEnd.empty()) {
+      unsigned int v = deadEnd.back();
+      deadEnd.pop_back();
+      if (live[v] > 0)
+        return v;
+    }
+    for (; cursor < vertexCount; cursor++)
+      if (live[cursor] > 0)
+        return static_cast<std::ptrdiff_t>(cursor);
+    return -1;
+  };
+
+  std::ptrdiff_t fan = skipDeadEnd();
+  while (fan >= 0) {
+    if (clusters && (clusters->empty() || candidates.empty()))
+      clusters->push_back(result.size() / 3);
+
+    // Выдача всех оставшихся треугольников веера
+    candidates.clear();
+    std::size_t v = static_cast<std::size_t>(fan);
+    for (std::size_t a = firstTriangle[v]; a < firstTriangle[v + 1]; a++) {
+      std::size_t triangle = adjacency[a];
+      if (emitted[triangle])
+        continue;
+      emitted[triangle] = true;
+      for (std::size_t k = 0; k < 3; k++) {
+        unsigned int index = indices[triangle * 3 + k];
+        result.push_back(index);
+        deadEnd.push_back(index);
+        candidates.push_back(index);
+        live[index]--;
+        if (time - cacheTime[index] > cacheSize)
+          cacheTime[index] = time++;
+      }
+    }
+
+    // Следующая вершина: самая старая из кандидатов, чей веер еще
+    // поместится в кеш
+    std::ptrdiff_t best = -1;
+    std::size_t bestPriority = 0;
+    for (unsigned int candidate : candidates) {
+      if (live[candidate] == 0)
+        continue;
+      std::size_t priority = 0;
+      if (time - cacheTime[candidate] + 2 * live[candidate] <= cacheSize)
+        priority = time - cacheTime[candidate];
+      if (best < 0 || priority > bestPriority) {
+        bestPriority = priority;
+        best = candidate;
+      }
+    }
+    if (best < 0) {
+      candidates.clear(); // Новый участок начинается после тупика
+      best = skipDeadEnd();
+    }
+    fan = best;
+  }
+  return result;
+}
+
+// Порядок кластеров против перерисовки
+// ------------------------------------
+// Кластеры (участки из optimizeVertexCache) сортируются по убыванию
+// dot(центр кластера - центр меша, нормаль кластера): внешние, смотрящие
+// наружу кластеры рисуются первыми и чаще перекрывают остальные при любом
+// направлении взгляда. Порядок треугольников внутри кластеров сохраняется,
+// поэтому эффективность кеша вершин почти не меняется.
+template <typename VertexT>
+std::vector<unsigned int>
+optimizeOverdraw(std::span<const unsigned int> indices,
+                 std::span<const VertexT> vertices,
+                 const std::vector<std::size_t> &clusters) {
+  std::size_t triangleCount = indices.size() / 3;
+  if (clusters.size() < 2)
+    return {indices.begin(), indices.end()};
+
+  struct Cluster {
+    std::size_t first, last;
+    float sortKey;
+  };
+  std::vector<Cluster> order(clusters.size());
+  std::vector<glm::vec3> centroids(clusters.size());
+  std::vector<glm::vec3> normals(clusters.size());
+
+  // Центры (взвешенные по площади) и нормали кластеров
+  glm::vec3 meshCentroid(0.f);
+  float meshArea = 0.f;
+  for (std::size_t c = 0; c < clusters.size(); c++) {
+    order[c].first = clusters[c];
+    order[c].last = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+    glm::vec3 weighted(0.f), normal(0.f);
+    float area = 0.f;
+    for (std::size_t t = order[c].first; t < order[c].last; t++) {
+      const glm::vec3 &p0 = vertices[indices[t * 3 + 0]].Position;
+      const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].Position;
+      const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].Position;
+      glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+      float faceArea = glm::length(faceNormal) * 0.5f;
+      weighted += (p0 + p1 + p2) * (faceArea / 3.f);
+      normal += faceNormal;
+      area += faceArea;
+    }
+    centroids[c] = area > 0.f ? weighted / area : glm::vec3(0.f);
+    normals[c] = normal;
+    meshCentroid += weighted;
+    meshArea += area;
+  }
+  if (meshArea > 0.f)
+    meshCentroid /= meshArea;
+
+  for (std::size_t c = 0; c < clusters.size(); c++) {
+    float length = glm::length(normals[c]);
+    order[c].sortKey =
+        length > 0.f
+            ? glm::dot(centroids[c] - meshCentroid, normals[c] / length)
+            : 0.f;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const Cluster &a, const Cluster &b) {
+                     return a.sortKey > b.sortKey;
+                   });
+
+  std::vector<unsigned int> result;
+  result.reserve(indices.size());
+  for (const Cluster &cluster : order)
+    result.insert(result.end(), indices.begin() + cluster.first * 3,
+                  indices.begin() + cluster.last * 3);
+  return result;
+}
+
+// Порядок вершин по первому использованию
+// ---------------------------------------
+// Вершины переставляются в порядке обращения к ним из индексов, чтобы
+// выборка вершин шла по памяти последовательно; неиспользуемые вершины
+// удаляются. Индексы переписываются на месте.
+template <typename VertexT>
+std::vector<VertexT> optimizeVertexFetch(std::span<const VertexT> vertices,
+                                         std::span<unsigned int> indices) {
+  constexpr unsigned int UNUSED = ~0u;
+  std::vector<unsigned int> remap(vertices.size(), UNUSED);
+  std::vector<VertexT> result;
+  result.reserve(vertices.size());
+  for (unsigned int &index : indices) {
+    if (remap[index] == UNUSED) {
+      remap[index] = static_cast<unsigned int>(result.size());
+      result.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+  return result;
+}
+
+} // namespace MeshOptimizer
+
+#endif
@@ -7,54 +7,258 @@
 // GLM
 #include <glm/glm.hpp>
 
-// STB
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb/stb_image.h>
-
 // Assimp
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+// Остальные библиотеки
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+
 // Остальные заголовочные файлы
+#include "AssetRegistry.h"
+#include "CommandBuffer.h"
+#include "Hash.h"
+#include "IndirectDraw.h"
+#include "InstanceBuffer.h"
+#include "MappedFile.h"
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 #include "Shader.h"
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+#include "VertexPacking.h"
 
 // Объявление функции загрузки текстуры из файла
 unsigned int TextureFromFile(const char *path, const std::string &directory,
                              bool gamma = false);
 
+// Флаги импорта Assimp (входят в ключ кеша мешей)
+constexpr std::uint32_t MODEL_IMPORT_FLAGS =
+    aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_FlipUVs |
+    aiProcess_CalcTangentSpace;
+
+// Дополнительные этапы импорта
+/* Оптимизация порядка треугольников и вершин (см. MeshOptimizer.h) */
+constexpr std::uint32_t MODEL_OPTIMIZE_MESHES = 1u << 0;
+/* Отдельный поток позиций для проходов глубины (см. Mesh.h) */
+constexpr std::uint32_t MODEL_SPLIT_POSITIONS = 1u << 1;
+constexpr std::uint32_t MODEL_DEFAULT_OPTIONS = MODEL_OPTIMIZE_MESHES;
+/* Опции, меняющие данные в кеше мешей (остальные применяются при загрузке
+   в GPU) */
+constexpr std::uint32_t MODEL_CACHE_OPTIONS = MODEL_OPTIMIZE_MESHES;
+
+// Данные меша на CPU до загрузки в GPU
+struct MeshData {
+  std::vector<Vertex> vertices; // Вершины импорта (до упаковки)
+  VertexFormatId vertexFormat;
+  std::vector<std::byte> packed; // Вершины в формате vertexFormat
+  VertexQuantization quantization;
+  std::vector<unsigned int> indices;
+  std::vector<Texture> textures;
+  float shininess;
+  // Статистика кеша вершин до и после оптимизации
+  bool optimized = false;
+  MeshOptimizer::CacheStats cacheBefore, cacheAfter;
+};
+
 class Model {
 public:
-  // Данные модели
-  // -------------
-  std::vector<Texture> textures_loaded;
-  std::vector<Mesh> meshes;
-  std::string directory;
+  // Данные модели (общие для всех экземпляров с тем же файлом)
+  // ----------------------------------------------------------
+  const ModelAsset *asset = nullptr;
   bool gammaCorrection;
+  std::uint32_t importOptions;
 
   // Конструктор
   // -----------
-  Model(std::string const &path, bool gamma = false) : gammaCorrection(gamma) {
-    loadModel(path);
+  // Повторная загрузка того же файла с теми же gamma и options берет готовые
+  // меши и текстуры из реестра ассетов без импорта и загрузки в GPU
+  Model(std::string const &path, bool gamma = false,
+        std::uint32_t options = MODEL_DEFAULT_OPTIONS)
+      : gammaCorrection(gamma), importOptions(options) {
+    asset = AssetRegistry::instance().acquireModel(
+        path, options, gamma,
+        [this, &path](ModelAsset &model, std::uint64_t sourceHash) {
+          loadModel(path, sourceHash, model);
+        });
+  }
+
+  Model(const Model &other)
+      : asset(other.asset), gammaCorrection(other.gammaCorrection),
+        importOptions(other.importOptions) {
+    if (asset)
+      AssetRegistry::instance().retain(asset);
+  }
+  Model &operator=(const Model &) = delete;
+  Model(Model &&other) noexcept
+      : asset(std::exchange(other.asset, nullptr)),
+        gammaCorrection(other.gammaCorrection),
+        importOptions(other.importOptions) {}
+  Model &operator=(Model &&) = delete;
+
+  ~Model() {
+    if (asset)
+      AssetRegistry::instance().release(asset);
+  }
+
+  // Меши модели
+  const std::vector<AnyMesh> &meshes() const { return asset->meshes; }
+
+  // Различные наборы возможностей материалов мешей (для выбора вариантов
+  // шейдера: каждый набор рисуется своим вариантом)
+  std::vector<std::uint32_t> materials() const {
+    std::vector<std::uint32_t> result;
+    for (const AnyMesh &mesh : asset->meshes) {
+      std::uint32_t features =
+          std::visit([](const auto &m) { return m.materialFeatures; }, mesh);
+      if (std::find(result.begin(), result.end(), features) == result.end())
+        result.push_back(features);
+    }
+    return result;
   }
 
   // Отрисовка
   // ---------
-  void Draw(Shader &shader) {
-    for (unsigned int i = 0; i < meshes.size(); i++)
-      meshes[i].Draw(shader);
+  // material - набор возможностей материала рисуемых мешей (ANY_MATERIAL -
+  // все меши)
+  void Draw(Shader &shader, std::uint32_t material = ANY_MATERIAL) {
+    for (const AnyMesh &mesh : asset->meshes)
+      std::visit(
+          [&](const auto &m) {
+            if (m.matches(material))
+              m.Draw(shader);
+          },
+          mesh);
+  }
+
+  // Отрисовка экземпляров с трансформациями из instances (один вызов на меш)
+  void DrawInstanced(Shader &shader, const InstanceBuffer &instances,
+                     std::uint32_t material = ANY_MATERIAL) {
+    auto count = static_cast<GLsizei>(instances.size());
+    instances.bind();
+    shader.drawUniforms().instancedDraw.set(true);
+    for (const AnyMesh &mesh : asset->meshes)
+      std::visit(
+          [&](const auto &m) {
+            if (m.matches(material))
+              m.DrawInstanced(shader, count);
+          },
+          mesh);
+    shader.drawUniforms().instancedDraw.set(false);
+  }
+
+  // Добавление мешей в список непрямой отрисовки. Экземпляры используют
+  // трансформации [transform, transform + instanceCount)
+  void Submit(IndirectDrawList &list, std::uint32_t transform,
+              std::uint32_t instanceCount = 1) const {
+    for (const AnyMesh &mesh : asset->meshes)
+      std::visit([&](const auto &m) { list.add(m, transform, instanceCount); },
+                 mesh);
+  }
+
+  // Запись мешей с трансформацией transform в проход pass буфера команд;
+  // shaderFor(материал) возвращает шейдер для набора возможностей
+  // материала меша (вызывается на потоке записи)
+  template <typename ShaderFor>
+  void Enqueue(CommandBuffer &commands, RenderPass pass,
+               std::uint32_t transform, ShaderFor &&shaderFor) const {
+    for (const AnyMesh &mesh : asset->meshes)
+      std::visit(
+          [&](const auto &m) {
+            commands.add(pass, shaderFor(m.materialFeatures), m, transform);
+          },
+          mesh);
+  }
+
+  // Отрисовка только позиций (проходы глубины, теней и выбора объектов)
+  void DrawDepth(Shader &shader) {
+    for (const AnyMesh &mesh : asset->meshes)
+      std::visit([&shader](const auto &m) { m.DrawDepth(shader); }, mesh);
+  }
+
+  // Отрисовка только позиций для экземпляров из instances
+  void DrawDepthInstanced(Shader &shader, const InstanceBuffer &instances) {
+    auto count = static_cast<GLsizei>(instances.size());
+    instances.bind();
+    shader.drawUniforms().instancedDraw.set(true);
+    for (const AnyMesh &mesh : asset->meshes)
+      std::visit([&](const auto &m) { m.DrawDepth(shader, count); }, mesh);
+    shader.drawUniforms().instancedDraw.set(false);
   }
 
 private:
+  // Хеш файлов материалов (строки "mtllib" файла .obj) поверх hash.
+  // Отсутствующий файл тоже меняет хеш, чтобы его появление сбросило кеш
+  static std::uint64_t materialLibrariesHash(const std::string &path,
+                                             const std::string &directory,
+                                             std::uint64_t hash) {
+    MappedFile file(path);
+    if (!file.isOpen())
+      return hash;
+    std::string_view text(reinterpret_cast<const char *>(file.data()),
+                          file.size());
+    constexpr std::string_view keyword = "mtllib";
+    for (std::size_t line = 0; line < text.size();) {
+      std::size_t end = text.find('\n', line);
+      if (end == std::string_view::npos)
+        end = text.size();
+      std::string_view current = text.substr(line, end - line);
+      line = end + 1;
+      if (!current.starts_with(keyword) || current.size() == keyword.size() ||
+          (current[keyword.size()] != ' ' && current[keyword.size()] != '\t'))
+        continue;
+
+      // Имена файлов через пробел
+      current.remove_prefix(keyword.size());
+      while (!current.empty()) {
+        std::size_t start = current.find_first_not_of(" \t\r");
+        if (start == std::string_view::npos)
+          break;
+        current.remove_prefix(start);
+        std::size_t length = current.find_first_of(" \t\r");
+        std::string_view name = current.substr(0, length);
+        current.remove_prefix(name.size());
+        hash = hashString(name, hash);
+        hash = hashValue(hashFile(directory + '/' + std::string(name)), hash);
+      }
+    }
+    return hash;
+  }
+
   // Загрузка модели
   // ---------------
-  void loadModel(std::string const &path) {
+  void loadModel(std::string const &path, std::uint64_t sourceHash,
+                 ModelAsset &model) {
+    // Извлечение пути к каталогу
+    model.path = path;
+    model.directory = path.substr(0, path.find_last_of('/'));
+
+    // Кеш хранит ссылки на текстуры из файлов материалов, поэтому их
+    // содержимое входит в ключ вместе с содержимым модели
+    if (sourceHash)
+      sourceHash = materialLibrariesHash(path, model.directory, sourceHash);
+
+    // Попытка загрузки из кеша (без обращения к Assimp)
+    std::string cacheFile = MeshCache::cachePath(path);
+    MeshCache::Reader cache;
+    std::uint32_t cacheOptions = importOptions & MODEL_CACHE_OPTIONS;
+    if (sourceHash && cache.open(cacheFile, sourceHash, MODEL_IMPORT_FLAGS,
+                                 cacheOptions)) {
+      loadFromCache(cache, model);
+      return;
+    }
+
     // Чтение файла с помощью ASSIMP
     Assimp::Importer importer;
-    const aiScene *scene = importer.ReadFile(
-        path, aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_FlipUVs |
-                  aiProcess_CalcTangentSpace);
+    const aiScene *scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
 
     // Проверка на ошибки
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
@@ -62,132 +266,276 @@ private:
       std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
       return;
     }
-    // Извлечение пути к каталогу
-    directory = path.substr(0, path.find_last_of('/'));
 
-    // Рекурсивная обработка корневого узла
-    processNode(scene->mRootNode, scene);
-  }
+    // Фаза 1: сбор списка мешей обходом дерева узлов
+    std::vector<const aiMesh *> sceneMeshes;
+    collectMeshes(scene->mRootNode, scene, sceneMeshes);
 
-  // Рекурсивная обработка узла
-  // --------------------------
-  void processNode(aiNode *node, const aiScene *scene) {
-    // Обработка всех узлов Mesh (если есть)
-    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-      aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-      meshes.push_back(processMesh(mesh, scene));
+    // Фаза 2: параллельная конвертация мешей в заранее выделенные массивы
+    // (результат каждого меша пишется в свой элемент, поэтому порядок
+    // мешей и их содержимое не зависят от числа потоков)
+    std::vector<MeshData> meshData(sceneMeshes.size());
+    ThreadPool::global().parallelFor(sceneMeshes.size(), [&](std::size_t i) {
+      convertMesh(sceneMeshes[i], scene, meshData[i], importOptions);
+    });
+    for (std::size_t i = 0; i < meshData.size(); i++) {
+      const MeshData &data = meshData[i];
+      if (data.optimized)
+        std::cout << "INFO::MESH_OPTIMIZER::" << path << "::MESH_" << i
+                  << " ACMR " << data.cacheBefore.acmr << " -> "
+                  << data.cacheAfter.acmr << ", ATVR " << data.cacheBefore.atvr
+                  << " -> " << data.cacheAfter.atvr << std::endl;
     }
-    // Обработка дочерних узлов
-    for (unsigned int i = 0; i < node->mNumChildren; i++) {
-      processNode(node->mChildren[i], scene);
+
+    // Материалы загружают текстуры, поэтому обрабатываются на потоке
+    // контекста в исходном порядке
+    for (std::size_t i = 0; i < sceneMeshes.size(); i++)
+      processMaterial(sceneMeshes[i], scene, meshData[i], model);
+
+    // Запись кеша для следующих запусков
+    if (sourceHash) {
+      std::vector<MeshCache::MeshEntry> entries;
+      for (const MeshData &data : meshData)
+        entries.push_back({data.vertexFormat, data.packed, data.indices,
+                           &data.textures, data.shininess, data.quantization});
+      if (!MeshCache::write(cacheFile, sourceHash, MODEL_IMPORT_FLAGS,
+                            cacheOptions, entries))
+        std::cout << "WARNING::MESH_CACHE::FAILED_TO_WRITE::" << cacheFile
+                  << std::endl;
     }
+
+    // Загрузка мешей в GPU
+    for (MeshData &data : meshData)
+      model.meshes.push_back(makeMesh(data.vertexFormat, data.packed,
+                                      data.indices, std::move(data.textures),
+                                      data.shininess, data.quantization));
   }
 
-  Mesh processMesh(aiMesh *mesh, const aiScene *scene) {
-    // Данные для заполнения
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
+  // Загрузка модели из кеша
+  // -----------------------
+  void loadFromCache(const MeshCache::Reader &cache, ModelAsset &model) {
+    model.meshes.reserve(cache.meshCount());
+    for (std::size_t i = 0; i < cache.meshCount(); i++) {
+      std::vector<Texture> textures;
+      for (const MeshCache::TextureRef &ref : cache.textures(i))
+        textures.push_back(loadTexture(
+            std::string(cache.string(ref.pathOffset, ref.pathLength)),
+            std::string(cache.string(ref.typeOffset, ref.typeLength)),
+            model));
+      // Вершины и индексы загружаются прямо из отображенного файла
+      model.meshes.push_back(makeMesh(
+          cache.vertexFormat(i), cache.vertices(i), cache.indices(i),
+          std::move(textures), cache.shininess(i), cache.quantization(i)));
+    }
+  }
+
+  // Создание меша формата vertexFormat
+  // ----------------------------------
+  AnyMesh makeMesh(VertexFormatId vertexFormat,
+                   std::span<const std::byte> vertices,
+                   std::span<const unsigned int> indices,
+                   std::vector<Texture> textures, float shininess,
+                   const VertexQuantization &quantization) const {
+    bool splitPositions = importOptions & MODEL_SPLIT_POSITIONS;
+    return visitVertexFormat(
+        vertexFormat, [&]<typename VertexT>(std::type_identity<VertexT>) {
+          std::span<const VertexT> typed(
+              reinterpret_cast<const VertexT *>(vertices.data()),
+              vertices.size() / sizeof(VertexT));
+          return AnyMesh(std::in_place_type<Mesh<VertexT>>, typed, indices,
+                         std::move(textures), shininess, quantization,
+                         splitPositions);
+        });
+  }
+
+  // Рекурсивный сбор мешей узла
+  // ----------------------------
+  void collectMeshes(const aiNode *node, const aiScene *scene,
+                     std::vector<const aiMesh *> &sceneMeshes) {
+    // Меши текущего узла (если есть)
+    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+      sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+    // Обработка дочерних узлов
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+      collectMeshes(node->mChildren[i], scene, sceneMeshes);
+  }
 
-    // Обработка всех вершин
+  // Конвертация вершин и индексов меша
+  // ----------------------------------
+  // Вызывается с рабочих потоков: не обращается к GL и к состоянию модели
+  static void convertMesh(const aiMesh *mesh, const aiScene *scene,
+                          MeshData &data, std::uint32_t options) {
+    /* Вершины */
+    data.vertices.resize(mesh->mNumVertices);
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-      Vertex vertex;
-      glm::vec3 vector;
+      Vertex &vertex = data.vertices[i];
       /* Позиции */
-      vector.x = mesh->mVertices[i].x;
-      vector.y = mesh->mVertices[i].y;
-      vector.z = mesh->mVertices[i].z;
-      vertex.Position = vector;
+      vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y,
+                                  mesh->mVertices[i].z);
       /* Нормали */
-      if (mesh->HasNormals()) {
-        vector.x = mesh->mNormals[i].x;
-        vector.y = mesh->mNormals[i].y;
-        vector.z = mesh->mNormals[i].z;
-        vertex.Normal = vector;
-      }
+      if (mesh->HasNormals())
+        vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y,
+                                  mesh->mNormals[i].z);
       /* Текстурные координаты */
       if (mesh->mTextureCoords[0]) {
         // Текстурные координаты
-        glm::vec2 vec;
-        vec.x = mesh->mTextureCoords[0][i].x;
-        vec.y = mesh->mTextureCoords[0][i].y;
-        vertex.TexCoords = vec;
+        vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x,
+                                     mesh->mTextureCoords[0][i].y);
         // Tangent
-        vector.x = mesh->mTangents[i].x;
-        vector.y = mesh->mTangents[i].y;
-        vector.z = mesh->mTangents[i].z;
-        vertex.Tangent = vector;
+        vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y,
+                                   mesh->mTangents[i].z);
         // Bitangent
-        vector.x = mesh->mBitangents[i].x;
-        vector.y = mesh->mBitangents[i].y;
-        vector.z = mesh->mBitangents[i].z;
-        vertex.Bitangent = vector;
-      } else {
-        vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+        vertex.Bitangent =
+            glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y,
+                      mesh->mBitangents[i].z);
+      }
+    }
+
+    /* Кости (у вершины остаются MAX_BONE_INFLUENCE самых весомых) */
+    for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+      const aiBone *bone = mesh->mBones[b];
+      for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+        Vertex &vertex = data.vertices[bone->mWeights[w].mVertexId];
+        float *slot = std::min_element(vertex.m_Weights,
+                                       vertex.m_Weights + MAX_BONE_INFLUENCE);
+        if (*slot < bone->mWeights[w].mWeight) {
+          *slot = bone->mWeights[w].mWeight;
+          vertex.m_BoneIDs[slot - vertex.m_Weights] = static_cast<int>(b);
+        }
       }
-      vertices.push_back(vertex);
     }
+    if (mesh->mNumBones > 0)
+      for (Vertex &vertex : data.vertices) {
+        float sum = 0.f;
+        for (float weight : vertex.m_Weights)
+          sum += weight;
+        if (sum > 0.f)
+          for (float &weight : vertex.m_Weights)
+            weight /= sum;
+      }
+
     /* Индексы вершин */
+    std::size_t indexCount = 0;
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+      indexCount += mesh->mFaces[i].mNumIndices;
+    data.indices.resize(indexCount);
+    unsigned int *out = data.indices.data();
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-      aiFace face = mesh->mFaces[i];
-      for (unsigned int j = 0; j < face.mNumIndices; j++)
-        indices.push_back(face.mIndices[j]);
+      const aiFace &face = mesh->mFaces[i];
+      out = std::copy_n(face.mIndices, face.mNumIndices, out);
     }
-    /* Материал */
+
+    /* Оптимизация (только для мешей из треугольников) */
+    if (options & MODEL_OPTIMIZE_MESHES &&
+        indexCount == std::size_t(mesh->mNumFaces) * 3)
+      optimizeMesh(data);
+
+    /* Упаковка вершин в минимальный формат */
+    // Касательные нужны только при наличии карты нормалей
+    const aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+    if (mesh->mNumBones > 0)
+      data.vertexFormat = VertexFormatId::Skinned;
+    else if (mesh->HasTangentsAndBitangents() &&
+             material->GetTextureCount(aiTextureType_HEIGHT) > 0)
+      data.vertexFormat = VertexFormatId::NormalMapped;
+    else if (mesh->HasNormals())
+      data.vertexFormat = VertexFormatId::Lit;
+    else
+      data.vertexFormat = VertexFormatId::Unlit;
+    auto pack = [&data]<typename VertexT>(std::type_identity<VertexT>) {
+      data.packed.resize(data.vertices.size() * sizeof(VertexT));
+      std::span<VertexT> packed(reinterpret_cast<VertexT *>(data.packed.data()),
+                                data.vertices.size());
+      return VertexPacking::pack<VertexT>(data.vertices, packed);
+    };
+    data.quantization = visitVertexFormat(data.vertexFormat, pack);
+    data.vertices = {};
+  }
+
+  // Оптимизация порядка треугольников и вершин
+  // ------------------------------------------
+  static void optimizeMesh(MeshData &data) {
+    data.cacheBefore = MeshOptimizer::analyzeVertexCache(data.indices,
+                                                         data.vertices.size());
+    std::vector<std::size_t> clusters;
+    data.indices = MeshOptimizer::optimizeVertexCache(
+        data.indices, data.vertices.size(), &clusters);
+    data.indices = MeshOptimizer::optimizeOverdraw<Vertex>(
+        data.indices, data.vertices, clusters);
+    data.vertices =
+        MeshOptimizer::optimizeVertexFetch<Vertex>(data.vertices, data.indices);
+    data.cacheAfter = MeshOptimizer::analyzeVertexCache(data.indices,
+                                                        data.vertices.size());
+    data.optimized = true;
+  }
+
+  // Загрузка материала меша
+  // -----------------------
+  void processMaterial(const aiMesh *mesh, const aiScene *scene,
+                       MeshData &data, ModelAsset &model) {
+    std::vector<Texture> &textures = data.textures;
     aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
     // Diffuse maps
     std::vector<Texture> diffuseMaps = loadMaterialTextures(
-        material, aiTextureType_DIFFUSE, "texture_diffuse");
+        material, aiTextureType_DIFFUSE, "texture_diffuse", model);
     textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
     // Specular maps
     std::vector<Texture> specularMaps = loadMaterialTextures(
-        material, aiTextureType_SPECULAR, "texture_specular");
+        material, aiTextureType_SPECULAR, "texture_specular", model);
     textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
     // Normal maps
-    std::vector<Texture> normalMaps =
-        loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
+    std::vector<Texture> normalMaps = loadMaterialTextures(
+        material, aiTextureType_HEIGHT, "texture_normal", model);
     textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
     // Height maps
-    std::vector<Texture> heightMaps =
-        loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
+    std::vector<Texture> heightMaps = loadMaterialTextures(
+        material, aiTextureType_AMBIENT, "texture_height", model);
     textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
     // Shininess
-    float matShininess;
     if (AI_SUCCESS !=
-        aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &matShininess)) {
+        aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &data.shininess)) {
       // if unsuccessful set a default
-      matShininess = 16.f;
+      data.shininess = 16.f;
     }
-
-    // Вывод
-    return Mesh(vertices, indices, textures, matShininess);
   }
 
   std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type,
-                                            std::string typeName) {
+                                            std::string typeName,
+                                            ModelAsset &model) {
     std::vector<Texture> textures;
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
       aiString str;
       mat->GetTexture(type, i, &str);
-      bool skip = false;
-      for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-        if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-          textures.push_back(textures_loaded[j]);
-          skip = true;
-          break;
-        }
-      }
-      if (!skip) {
-        Texture texture;
-        texture.id = TextureFromFile(str.C_Str(), this->directory);
-        texture.type = typeName;
-        texture.path = str.C_Str();
-        textures.push_back(texture);
-        textures_loaded.push_back(texture);
-      }
+      textures.push_back(loadTexture(str.C_Str(), typeName, model));
     }
     return textures;
   }
+
+  // Назначение текстуры по типу (определяет формат блочного сжатия)
+  static TextureRole textureRole(const std::string &typeName) {
+    if (typeName == "texture_diffuse")
+      return TextureRole::Diffuse;
+    if (typeName == "texture_specular")
+      return TextureRole::Specular;
+    if (typeName == "texture_normal")
+      return TextureRole::Normal;
+    return TextureRole::Color;
+  }
+
+  // Загрузка текстуры через реестр ассетов (повторно используемые текстуры
+  // находятся по пути, gamma и назначению)
+  Texture loadTexture(const std::string &path, const std::string &typeName,
+                      ModelAsset &model) {
+    const TextureAsset *textureAsset = AssetRegistry::instance().acquireTexture(
+        model.directory + '/' + path, gammaCorrection, textureRole(typeName));
+    model.textures.push_back(textureAsset);
+
+    Texture texture;
+    texture.id = textureAsset->id;
+    texture.type = typeName;
+    texture.path = path;
+    return texture;
+  }
 };
 
 unsigned int TextureFromFile(const char *path, const std::string &directory,
@@ -195,47 +543,7 @@ unsigned int TextureFromFile(const char *path, const std::string &directory,
   std::string filename = std::string(path);
   filename = directory + '/' + filename;
 
-  unsigned int textureID;
-  glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
-
-  stbi_set_flip_vertically_on_load(true);
-
-  int width, height, nrComponents;
-  unsigned char *data =
-      stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-  if (data) {
-    GLenum mainFormat;
-    GLenum subFormat;
-    if (nrComponents == 1) {
-      mainFormat = GL_RED;
-      subFormat = GL_RED;
-    } else if (nrComponents == 3) {
-      mainFormat = GL_RGB8;
-      subFormat = GL_RGB;
-    } else if (nrComponents == 4) {
-      mainFormat = GL_RGBA8;
-      subFormat = GL_RGBA;
-    } else {
-      std::cout << "Texture failed to load at path: " << path << std::endl;
-      std::cout << "Because couldn't designate nrComponents" << std::endl;
-    }
-
-    glTextureStorage2D(textureID, 1, mainFormat, width, height);
-    glTextureSubImage2D(textureID, 0, 0, 0, width, height, subFormat,
-                        GL_UNSIGNED_BYTE, data);
-    glGenerateTextureMipmap(textureID);
-
-    glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER,
-                        GL_LINEAR_MIPMAP_LINEAR);
-    glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  } else {
-    std::cout << "Texture failed to load at path: " << path << std::endl;
-  }
-  stbi_image_free(data);
-
-  return textureID;
+  // Текстура декодируется в фоне, до загрузки вместо нее рисуется заглушка
+  return TextureStreamer::instance().load(filename, gamma);
 }
 #endif
@@ -0,0 +1,147 @@
+#ifndef OFFSET_ALLOCATOR_H
+#define OFFSET_ALLOCATOR_H
+
+// Остальные библиотеки
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Распределитель смещений
+// -----------------------
+// Выделяет непрерывные диапазоны в абстрактном пространстве [0, capacity)
+// (в элементах, а не байтах) и сам памяти не владеет. Свободные блоки
+// хранятся в двух упорядоченных индексах: по размеру для выбора наименьшего
+// подходящего блока (best fit) и по смещению для слияния соседних блоков при
+// освобождении, поэтому обе операции выполняются за O(log n).
+class OffsetAllocator {
+public:
+  static constexpr std::uint32_t INVALID = ~0u;
+
+  OffsetAllocator() = default;
+  explicit OffsetAllocator(std::uint32_t capacity) { reset(capacity); }
+
+  // Выделение size элементов (INVALID, если подходящего блока нет)
+  std::uint32_t allocate(std::uint32_t size) {
+    if (size == 0)
+      return INVALID;
+    auto fit = freeBySize.lower_bound(size);
+    if (fit == freeBySize.end())
+      return INVALID;
+    std::uint32_t blockSize = fit->first, offset = fit->second;
+    eraseFree(offset, blockSize);
+    if (blockSize > size)
+      insertFree(offset + size, blockSize - size);
+    allocated[offset] = size;
+    usedSize += size;
+    return offset;
+  }
+
+  // Освобождение диапазона, начинающегося с offset
+  void free(std::uint32_t offset) {
+    auto it = allocated.find(offset);
+    if (it == allocated.end())
+      return;
+    std::uint32_t size = it->second;
+    allocated.erase(it);
+    usedSize -= size;
+
+    // Слияние с соседними свободными блоками
+    auto next = freeByOffset.lower_bound(offset);
+    if (next != freeByOffset.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == offset) {
+        offset = prev->first;
+        size += prev->second;
+        eraseFree(prev->first, prev->second);
+      }
+    }
+    next = freeByOffset.lower_bound(offset + size);
+    if (next != freeByOffset.end() && next->first == offset + size) {
+      size += next->second;
+      eraseFree(next->first, next->second);
+    }
+    insertFree(offset, size);
+  }
+
+  // Расширение пространства (новые элементы добавляются в конец)
+  void grow(std::uint32_t newCapacity) {
+    if (newCapacity <= totalSize)
+      return;
+    std::uint32_t offset = totalSize, size = newCapacity - totalSize;
+    totalSize = newCapacity;
+    // Слияние с последним свободным блоком
+    if (!freeByOffset.empty()) {
+      auto last = std::prev(freeByOffset.end());
+      if (last->first + last->second == offset) {
+        offset = last->first;
+        size += last->second;
+        eraseFree(last->first, last->second);
+      }
+    }
+    insertFree(offset, size);
+  }
+
+  // Сброс: все пространство свободно
+  void reset(std::uint32_t capacity) {
+    freeBySize.clear();
+    freeByOffset.clear();
+    allocated.clear();
+    totalSize = capacity;
+    usedSize = 0;
+    if (capacity > 0)
+      insertFree(0, capacity);
+  }
+
+  // Уплотнение: занятые диапазоны переносятся в начало пространства в
+  // порядке смещений. Возвращает пары (старое смещение, новое смещение)
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> compact() {
+    std::map<std::uint32_t, std::uint32_t> ordered(allocated.begin(),
+                                                  allocated.end());
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> moves;
+    moves.reserve(ordered.size());
+    reset(totalSize);
+    for (const auto &[offset, size] : ordered)
+      moves.emplace_back(offset, allocate(size));
+    return moves;
+  }
+
+  // Размер занятого диапазона (0, если offset не выделен)
+  std::uint32_t sizeOf(std::uint32_t offset) const {
+    auto it = allocated.find(offset);
+    return it == allocated.end() ? 0 : it->second;
+  }
+
+  std::uint32_t capacity() const { return totalSize; }
+  std::uint32_t used() const { return usedSize; }
+  std::uint32_t available() const { return totalSize - usedSize; }
+  std::uint32_t largestFree() const {
+    return freeBySize.empty() ? 0 : std::prev(freeBySize.end())->first;
+  }
+
+private:
+  std::multimap<std::uint32_t, std::uint32_t> freeBySize; // размер->смещение
+  std::map<std::uint32_t, std::uint32_t> freeByOffset;    // смещение->размер
+  std::unordered_map<std::uint32_t, std::uint32_t> allocated;
+  std::uint32_t totalSize = 0;
+  std::uint32_t usedSize = 0;
+
+  void insertFree(std::uint32_t offset, std::uint32_t size) {
+    freeBySize.emplace(size, offset);
+    freeByOffset.emplace(offset, size);
+  }
+
+  void eraseFree(std::uint32_t offset, std::uint32_t size) {
+    freeByOffset.erase(offset);
+    auto [first, last] = freeBySize.equal_range(size);
+    for (auto it = first; it != last; ++it)
+      if (it->second == offset) {
+        freeBySize.erase(it);
+        return;
+      }
+  }
+};
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "Hash.h"       // Хеширование
+#include "MappedFile.h" // Отображение файла в память
+
+// Кеш двоичных программ
+// ---------------------
+// Слинкованная программа сохраняется через glGetProgramBinary в файл
+// DIRECTORY/<ключ>.progbin и при следующем запуске загружается через
+// glProgramBinary без компиляции. Ключ - хеш исходного кода всех стадий
+// (вместе с определениями вариантов) и строк производителя, устройства и
+// версии драйвера; формат двоичного кода хранится в заголовке. Драйвер
+// вправе отвергнуть двоичный код (например, после обновления) - тогда
+// load() возвращает false, и программа компилируется из исходников.
+//
+// Структура файла:
+//   Header
+//   двоичный код программы (Header::size байт)
+namespace ProgramCache {
+
+constexpr char MAGIC[4] = {'L', 'G', 'P', 'C'};
+// Версия формата: увеличивать при изменении структуры файла
+constexpr std::uint32_t VERSION = 1;
+constexpr const char *DIRECTORY = "./resources/Shaders/cache";
+
+// Заголовок файла
+struct Header {
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t key;
+  std::uint32_t format;
+  std::uint32_t size;
+};
+
+// Хеш строк драйвера (двоичный код действителен только для того же
+// драйвера); 0, если драйвер не поддерживает ни одного формата
+inline std::uint64_t driverHash() {
+  static const std::uint64_t hash = [] {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+      std::cout << "INFO::PROGRAM_CACHE::NO_BINARY_FORMATS" << std::endl;
+      return std::uint64_t(0);
+    }
+    std::uint64_t h = FNV_OFFSET_BASIS;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+      const GLubyte *str = glGetString(name);
+      if (str)
+        h = hashString(reinterpret_cast<const char *>(str), h);
+      // Разделитель строк
+      h = hashValue(name, h);
+    }
+    return h;
+  }();
+  return hash;
+}
+
+// Поддерживает ли драйвер формат двоичного кода
+inline bool supportedFormat(GLenum format) {
+  static const std::vector<GLint> formats = [] {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    std::vector<GLint> list(static_cast<std::size_t>(std::max(count, 0)));
+    if (!list.empty())
+      glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, list.data());
+    return list;
+  }();
+  for (GLint supported : formats)
+    if (static_cast<GLenum>(supported) == format)
+      return true;
+  return false;
+}
+
+// Ключ программы по исходному коду стадий (0 - кеш недоступен)
+inline std::uint64_t programKey(std::initializer_list<std::string_view> code) {
+  std::uint64_t driver = driverHash();
+  if (!driver)
+    return 0;
+  std::uint64_t key = hashValue(VERSION, driver);
+  for (std::string_view stage : code) {
+    key = hashValue(stage.size(), key);
+    key = hashString(stage, key);
+  }
+  return key;
+}
+
+// Путь к файлу кеша для ключа
+inline std::string cachePath(std::uint64_t key) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.progbin",
+                static_cast<unsigned long long>(key));
+  return std::string(DIRECTORY) + "/" + name;
+}
+
+// Загрузка программы из кеша (false - файла нет, он устарел или двоичный
+// код отвергнут драйвером; программу нужно собрать из исходников)
+inline bool load(GLuint program, std::uint64_t key) {
+  if (!key)
+    return false;
+  MappedFile file(cachePath(key));
+  if (!file.isOpen() || file.size() < sizeof(Header))
+    return false;
+
+  const Header &header = *reinterpret_cast<const Header *>(file.data());
+  if (std::string_view(header.magic, 4) != std::string_view(MAGIC, 4) ||
+      header.version != VERSION || header.key != key ||
+      header.size != file.size() - sizeof(Header) ||
+      !supportedFormat(header.format))
+    return false;
+
+  glProgramBinary(program, header.format, file.data() + sizeof(Header),
+                  static_cast<GLsizei>(header.size));
+  GLint success = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    std::cout << "INFO::PROGRAM_CACHE::BINARY_REJECTED::" << cachePath(key)
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Сохранение слинкованной программы (перед линковкой нужно выставить
+// GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+inline bool store(GLuint program, std::uint64_t key) {
+  if (!key)
+    return false;
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return false;
+
+  Header header = {};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.key = key;
+  std::vector<char> binary(static_cast<std::size_t>(length));
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+  header.format = format;
+  header.size = static_cast<std::uint32_t>(length);
+
+  std::error_code error;
+  std::filesystem::create_directories(DIRECTORY, error);
+  std::string path = cachePath(key);
+  std::string tmpPath = temporaryPath(path);
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+      return false;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(binary.data(), length);
+    if (!out) {
+      out.close();
+      std::remove(tmpPath.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    std::cout << "WARNING::PROGRAM_CACHE::FAILED_TO_WRITE::" << path
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+} // namespace ProgramCache
+
+#endif
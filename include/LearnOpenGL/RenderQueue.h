@@ -0,0 +1,239 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "CommandBuffer.h" // Буфер команд
+#include "GLState.h"       // Кеш состояния OpenGL
+#include "IndirectDraw.h"  // Непрямая отрисовка
+#include "Shader.h"        // Класс шейдера
+#include "ThreadPool.h"    // Пул потоков
+
+// Очередь отрисовки
+// -----------------
+// Очередь одного вида (камеры). record() делит элементы сцены на участки
+// и записывает их параллельно на рабочих потоках - по буферу команд на
+// поток (CommandBuffer.h); каждый буфер сортируется тем же потоком.
+// submit() на потоке контекста сливает отсортированные буферы по ключу и
+// воспроизводит команды одного прохода, поэтому порядок отрисовки тот же,
+// что при одной общей сортировке, а все вызовы GL остаются в одном
+// контексте. При равных ключах раньше идет буфер с меньшим номером, и
+// порядок не зависит от распределения участков по потокам.
+//
+// Слитые команды прохода загружаются в буферы непрямой отрисовки
+// (IndirectDraw.h) и рисуются glMultiDrawElementsIndirect: один вызов на
+// каждую непрерывную группу с одной программой, набором текстур и VAO.
+// Трансформация и деквантование берутся шейдером из SSBO по
+// drawBase + gl_DrawID, индекс материала - из baseInstance.
+class RenderQueue {
+public:
+  // Наименьшее число элементов на буфер (меньшие участки не окупают
+  // передачу на рабочий поток)
+  static constexpr std::size_t MIN_RECORD_ITEMS = 256;
+
+  // Запись кадра для вида view: recordFn(buffer, first, last) записывает
+  // элементы [first, last) в buffer; вызывается параллельно для разных
+  // буферов, поэтому не должна вызывать GL и менять общие данные
+  template <typename RecordFn>
+  void record(const RenderView &view, std::size_t count,
+              RecordFn &&recordFn) {
+    ThreadPool &pool = ThreadPool::global();
+    std::size_t jobs = std::clamp<std::size_t>(
+        (count + MIN_RECORD_ITEMS - 1) / MIN_RECORD_ITEMS, 1,
+        pool.size() + 1);
+    buffers.resize(jobs);
+    pool.parallelFor(jobs, [&](std::size_t job) {
+      CommandBuffer &buffer = buffers[job];
+      buffer.clear(view);
+      recordFn(buffer, count * job / jobs, count * (job + 1) / jobs);
+      buffer.sort();
+    });
+
+    // Трансформации буферов подряд: индексы буфера job сдвигаются на
+    // transformBases[job]
+    transforms.clear();
+    transformBases.clear();
+    for (const CommandBuffer &buffer : buffers) {
+      transformBases.push_back(static_cast<std::uint32_t>(transforms.size()));
+      const std::vector<IndirectTransform> &data = buffer.transformData();
+      transforms.insert(transforms.end(), data.begin(), data.end());
+    }
+    transformsUploaded = false;
+  }
+
+  // Отрисовка команд прохода pass в порядке ключа (поток контекста)
+  void submit(RenderPass pass) {
+    merge(pass);
+    if (indirect.empty())
+      return;
+
+    // Трансформации всех буферов загружаются один раз за запись (их
+    // читают оба прохода), команды и параметры - один раз за проход
+    if (!transformsUploaded) {
+      uploadIndirectBuffer(transformBuffer, transformCapacity,
+                           transforms.data(),
+                           transforms.size() * sizeof(IndirectTransform));
+      transformsUploaded = true;
+    }
+    uploadIndirectBuffer(
+        commandBuffer, commandCapacity, indirect.data(),
+        indirect.size() * sizeof(DrawElementsIndirectCommand));
+    uploadIndirectBuffer(drawBuffer, drawCapacity, drawData.data(),
+                         drawData.size() * sizeof(IndirectDrawData));
+
+    GLState &state = GLState::instance();
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INDIRECT_DRAW_BINDING,
+                         drawBuffer);
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INDIRECT_TRANSFORM_BINDING,
+                         transformBuffer);
+    state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    Shader *shader = nullptr;
+    for (const Batch &batch : batches) {
+      if (batch.shader != shader) {
+        if (shader)
+          shader->drawUniforms().indirectDraw.set(false);
+        shader = batch.shader;
+        shader->use();
+        shader->drawUniforms().indirectDraw.set(true);
+      }
+      if (batch.material)
+        batch.material->bind();
+      shader->drawUniforms().drawBase.set(batch.first);
+      state.bindVertexArray(batch.vao);
+      glMultiDrawElementsIndirect(
+          GL_TRIANGLES, GL_UNSIGNED_INT,
+          reinterpret_cast<const void *>(std::uintptr_t(batch.first) *
+                                         sizeof(DrawElementsIndirectCommand)),
+          static_cast<GLsizei>(batch.count), 0);
+    }
+    shader->drawUniforms().indirectDraw.set(false);
+    state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+
+  // Число записанных и отброшенных отсечением команд
+  std::size_t size() const {
+    std::size_t count = 0;
+    for (const CommandBuffer &buffer : buffers)
+      count += buffer.size();
+    return count;
+  }
+  std::size_t culled() const {
+    std::size_t count = 0;
+    for (const CommandBuffer &buffer : buffers)
+      count += buffer.culled();
+    return count;
+  }
+  // Число буферов команд последней записи
+  std::size_t bufferCount() const { return buffers.size(); }
+  // Число вызовов glMultiDrawElementsIndirect последнего прохода
+  std::size_t batchCount() const { return batches.size(); }
+
+  // Число смен программы и набора текстур с прошлого вызова
+  std::size_t takeStateChanges() { return std::exchange(stateChanges, 0); }
+
+  // Удаление буферов (до уничтожения контекста)
+  void release() {
+    GLState::instance().deleteBuffers(1, &commandBuffer);
+    GLState::instance().deleteBuffers(1, &drawBuffer);
+    GLState::instance().deleteBuffers(1, &transformBuffer);
+    commandBuffer = drawBuffer = transformBuffer = 0;
+    commandCapacity = drawCapacity = transformCapacity = 0;
+    transformsUploaded = false;
+  }
+
+private:
+  using SortEntry = CommandBuffer::SortEntry;
+
+  // Вызов glMultiDrawElementsIndirect: команды [first, first + count)
+  struct Batch {
+    Shader *shader;
+    const MaterialBinding *material; // nullptr - набор текстур не меняется
+    unsigned int vao;
+    std::uint32_t first, count;
+  };
+
+  std::vector<CommandBuffer> buffers;
+  std::vector<std::pair<const SortEntry *, const SortEntry *>> heads;
+  std::size_t stateChanges = 0;
+
+  // Данные прохода в порядке отрисовки
+  std::vector<IndirectTransform> transforms;
+  std::vector<std::uint32_t> transformBases;
+  std::vector<DrawElementsIndirectCommand> indirect;
+  std::vector<IndirectDrawData> drawData;
+  std::vector<Batch> batches;
+  bool transformsUploaded = false;
+  unsigned int commandBuffer = 0, drawBuffer = 0, transformBuffer = 0;
+  std::size_t commandCapacity = 0, drawCapacity = 0, transformCapacity = 0;
+
+  // Слияние отсортированных буферов: команды прохода pass в порядке ключа
+  // и группы с одинаковым состоянием
+  void merge(RenderPass pass) {
+    heads.clear();
+    for (const CommandBuffer &buffer : buffers)
+      heads.push_back(buffer.passRange(pass));
+    indirect.clear();
+    drawData.clear();
+    batches.clear();
+
+    Shader *shader = nullptr;
+    const MaterialBinding *material = nullptr;
+    unsigned int vao = 0;
+    for (;;) {
+      // Буфер с наименьшим ключом (буферов - по числу потоков, поэтому
+      // линейный поиск быстрее кучи)
+      std::size_t next = heads.size();
+      for (std::size_t i = 0; i < heads.size(); i++)
+        if (heads[i].first != heads[i].second &&
+            (next == heads.size() ||
+             heads[i].first->key < heads[next].first->key))
+          next = i;
+      if (next == heads.size())
+        break;
+
+      const DrawCommand &command =
+          buffers[next].command(heads[next].first->index);
+      ++heads[next].first;
+
+      // Новая группа при смене программы, набора текстур или VAO
+      bool split = false;
+      const MaterialBinding *bind = nullptr;
+      if (command.shader != shader) {
+        shader = command.shader;
+        stateChanges++;
+        split = true;
+      }
+      if (command.material && (!material || material->textureSet !=
+                                                command.material->textureSet)) {
+        material = bind = command.material;
+        stateChanges++;
+        split = true;
+      }
+      if (command.vao != vao) {
+        vao = command.vao;
+        split = true;
+      }
+      if (split)
+        batches.push_back(
+            {shader, bind, vao, static_cast<std::uint32_t>(indirect.size()),
+             0});
+      batches.back().count++;
+
+      indirect.push_back(command.indirect);
+      IndirectDrawData data = command.data;
+      data.transform += transformBases[next];
+      drawData.push_back(data);
+    }
+  }
+};
+
+#endif
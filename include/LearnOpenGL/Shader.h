@@ -11,14 +11,33 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+
+// Остальные заголовочные файлы
+#include "GLState.h"        // Кеш состояния OpenGL
+#include "ProgramCache.h"   // Кеш двоичных программ
+#include "ShaderCompiler.h" // Параллельная компиляция шейдеров
+#include "UniformTable.h"   // Таблица uniform-переменных
 
 // Класс шейдера
+// Uniform-переменные ищутся по таблице, построенной при линковке (см.
+// UniformTable.h), и загружаются только при изменении значения. Таблица
+// хранится в объекте, поэтому шейдер не копируется и не перемещается.
+// Слинкованные программы сохраняются в кеш двоичных программ
+// (ProgramCache.h) и при следующем запуске загружаются без компиляции.
+// Проверка ошибок, чтение uniform-переменных и запись в кеш выполняются в
+// finish(): до этого драйвер может компилировать программу параллельно
+// (ShaderCompiler.h), а ready() опрашивает готовность без ожидания.
 class Shader {
 public:
   unsigned int ID; // ID шейдера
   // Конструктор считывает и строит шейдер
   // -------------------------------------
-  Shader(const char *vertexPath, const char *fragmentPath) {
+  // defines вставляются после строки #version обоих шейдеров (варианты,
+  // см. ShaderVariants.h). Если async, сборка завершается в ready() или
+  // finish(), иначе - сразу
+  Shader(const char *vertexPath, const char *fragmentPath,
+         const std::string &defines = "", bool async = false) {
     // Получаем код вершинного шейдера из файла
     // Вершинный шейдер
     std::string vertexCode;
@@ -45,12 +64,21 @@ public:
       vShaderFile.close();
       fShaderFile.close();
       // Конвертируем потоки в строковые переменные
-      vertexCode = vShaderStream.str();
-      fragmentCode = fShaderStream.str();
+      vertexCode = insertDefines(vShaderStream.str(), defines);
+      fragmentCode = insertDefines(fShaderStream.str(), defines);
     } catch (std::ifstream::failure &e) {
       std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
     }
 
+    // Загружаем программу из кеша, если двоичный код подходит
+    cacheKey = ProgramCache::programKey({vertexCode, fragmentCode});
+    ID = glCreateProgram();
+    resolveDrawUniforms();
+    if (ProgramCache::load(ID, cacheKey)) {
+      uniforms.reflect(ID);
+      return;
+    }
+
     // Конвертируем строковые переменные в массивы символов
     const char *vShaderCode = vertexCode.c_str();
     const char *fShaderCode = fragmentCode.c_str();
@@ -65,10 +93,8 @@ public:
     vertex = glCreateShader(GL_VERTEX_SHADER);
     // Передаем код шейдера
     glShaderSource(vertex, 1, &vShaderCode, NULL);
-    // Компилируем шейдер
+    // Компилируем шейдер (ошибки проверяются в finish())
     glCompileShader(vertex);
-    // Проверяем на ошибки
-    checkCompileErrors(vertex, "VERTEX");
 
     // Создаем фрагментный шейдер
     // Строим шейдер
@@ -77,95 +103,222 @@ public:
     glShaderSource(fragment, 1, &fShaderCode, NULL);
     // Компилируем шейдер
     glCompileShader(fragment);
-    // Проверяем на ошибки
-    checkCompileErrors(fragment, "FRAGMENT");
 
-    // Создаем шейдерную программу
-    ID = glCreateProgram();
     // Прикрепляем вершинный шейдер
     glAttachShader(ID, vertex);
     // Прикрепляем фрагментный шейдер
     glAttachShader(ID, fragment);
-    // Связываем шейдерную программу
+    // Связываем шейдерную программу (двоичный код понадобится для кеша)
+    glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(ID);
+
+    // Запоминаем шейдеры до завершения сборки
+    stages[0] = {vertex, "VERTEX"};
+    stages[1] = {fragment, "FRAGMENT"};
+    pending = true;
+    if (!async)
+      finish();
+  }
+
+  // Конструктор вычислительного шейдера
+  // -----------------------------------
+  explicit Shader(const char *computePath) {
+    std::string computeCode;
+    std::ifstream cShaderFile;
+    cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try {
+      cShaderFile.open(computePath);
+      std::stringstream cShaderStream;
+      cShaderStream << cShaderFile.rdbuf();
+      cShaderFile.close();
+      computeCode = cShaderStream.str();
+    } catch (std::ifstream::failure &e) {
+      std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+    }
+    cacheKey = ProgramCache::programKey({computeCode});
+    ID = glCreateProgram();
+    resolveDrawUniforms();
+    if (ProgramCache::load(ID, cacheKey)) {
+      uniforms.reflect(ID);
+      return;
+    }
+    const char *cShaderCode = computeCode.c_str();
+
+    unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cShaderCode, NULL);
+    glCompileShader(compute);
+
+    glAttachShader(ID, compute);
+    glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
-    // Проверяем на ошибки
-    checkCompileErrors(ID, "PROGRAM");
+    stages[0] = {compute, "COMPUTE"};
+    pending = true;
+    finish();
+  }
+
+  Shader(const Shader &) = delete;
+  Shader &operator=(const Shader &) = delete;
 
-    // Удаляем шейдеры, так как они уже связаны с
-    // нашей программой и больше не нужны
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+  // Готова ли программа (без ожидания); готовая программа собирается до
+  // конца через finish()
+  // ------------------------------------------------------------------------
+  bool ready() {
+    if (pending && !ShaderCompiler::instance().completed(ID))
+      return false;
+    finish();
+    return true;
+  }
+
+  // Завершение сборки: ожидание компиляции, проверка ошибок, чтение
+  // uniform-переменных и сохранение программы в кеш
+  // ------------------------------------------------------------------------
+  void finish() {
+    if (!pending)
+      return;
+    pending = false;
+    bool success = true;
+    for (Stage &stage : stages) {
+      if (!stage.shader)
+        continue;
+      success = checkCompileErrors(stage.shader, stage.type) && success;
+      // Удаляем шейдеры, так как они уже связаны с
+      // нашей программой и больше не нужны
+      glDeleteShader(stage.shader);
+      stage.shader = 0;
+    }
+    if (checkCompileErrors(ID, "PROGRAM") && success)
+      ProgramCache::store(ID, cacheKey);
+    // Перечисляем активные uniform-переменные
+    uniforms.reflect(ID);
   }
 
   // Активация шейдерной программы
   // ------------------------------------------------------------------------
-  void use() { glUseProgram(ID); }
+  void use() { GLState::instance().useProgram(ID); }
 
   // Удаление шейдерной программы
   // ------------------------------------------------------------------------
-  void deleteProgram() { glDeleteProgram(ID); }
+  void deleteProgram() { GLState::instance().deleteProgram(ID); }
 
-  // Утилитные функции
+  // Описатель uniform-переменной для хранения в цикле рендеринга
   // ------------------------------------------------------------------------
-  void setBool(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+  template <typename T> UniformHandle<T> uniform(std::string_view name) const {
+    return UniformHandle<T>(&uniforms, ID, name);
   }
+
+  // Uniform-переменные, загружаемые при каждой отрисовке (Mesh, Model,
+  // IndirectDraw.h). Описатели получаются один раз при создании программы,
+  // поэтому вызовы отрисовки не хешируют строк и не ищут переменные
   // ------------------------------------------------------------------------
-  void setInt(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
-  }
+  struct DrawUniforms {
+    UniformHandle<glm::mat4> model;
+    UniformHandle<glm::mat3> normalMatrix;
+    UniformHandle<glm::vec3> posOffset, posScale;
+    UniformHandle<bool> instancedDraw, indirectDraw;
+    UniformHandle<unsigned int> drawBase;
+  };
+  const DrawUniforms &drawUniforms() const { return draw; }
+
+  // Загрузка значения по имени (пропускается, если значение не изменилось)
   // ------------------------------------------------------------------------
-  void setUInt(const std::string &name, unsigned int value) const {
-    glUniform1ui(glGetUniformLocation(ID, name.c_str()), value);
+  template <typename T> void set(std::string_view name, const T &value) const {
+    std::uint32_t index = uniforms.find(name);
+    if (index != UniformTable::NOT_FOUND && uniforms.update(index, value))
+      detail::programUniform(ID, uniforms[index].location, value);
   }
+
+  // Утилитные функции
+  // ------------------------------------------------------------------------
+  void setBool(std::string_view name, bool value) const { set(name, value); }
+  // ------------------------------------------------------------------------
+  void setInt(std::string_view name, int value) const { set(name, value); }
   // ------------------------------------------------------------------------
-  void setFloat(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+  void setUInt(std::string_view name, unsigned int value) const {
+    set(name, value);
   }
   // ------------------------------------------------------------------------
-  void setVec2(const std::string &name, const glm::vec2 &value) const {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+  void setFloat(std::string_view name, float value) const { set(name, value); }
+  // ------------------------------------------------------------------------
+  void setVec2(std::string_view name, const glm::vec2 &value) const {
+    set(name, value);
   }
   // ------------------------------------------------------------------------
-  void setVec2(const std::string &name, float x, float y) const {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+  void setVec2(std::string_view name, float x, float y) const {
+    set(name, glm::vec2(x, y));
   }
   // ------------------------------------------------------------------------
-  void setVec3(const std::string &name, const glm::vec3 &value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+  void setVec3(std::string_view name, const glm::vec3 &value) const {
+    set(name, value);
   }
   // ------------------------------------------------------------------------
-  void setVec3(const std::string &name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+  void setVec3(std::string_view name, float x, float y, float z) const {
+    set(name, glm::vec3(x, y, z));
   }
   // ------------------------------------------------------------------------
-  void setVec4(const std::string &name, const glm::vec4 &value) const {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+  void setVec4(std::string_view name, const glm::vec4 &value) const {
+    set(name, value);
   }
   // ------------------------------------------------------------------------
-  void setVec4(const std::string &name, float x, float y, float z, float w) {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+  void setVec4(std::string_view name, float x, float y, float z, float w) {
+    set(name, glm::vec4(x, y, z, w));
   }
   // ------------------------------------------------------------------------
-  void setMat2(const std::string &name, const glm::mat2 &mat) const {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                       &mat[0][0]);
+  void setMat2(std::string_view name, const glm::mat2 &mat) const {
+    set(name, mat);
   }
   // ------------------------------------------------------------------------
-  void setMat3(const std::string &name, const glm::mat3 &mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                       &mat[0][0]);
+  void setMat3(std::string_view name, const glm::mat3 &mat) const {
+    set(name, mat);
   }
   // ------------------------------------------------------------------------
-  void setMat4(const std::string &name, const glm::mat4 &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                       &mat[0][0]);
+  void setMat4(std::string_view name, const glm::mat4 &mat) const {
+    set(name, mat);
   }
 
 private:
-  // Проверка на ошибки компиляции/линковки шейдеров
-  // -----------------------------------------------
-  void checkCompileErrors(unsigned int shader, std::string type) {
+  // Таблица uniform-переменных (копии значений меняются и в const-методах)
+  mutable UniformTable uniforms;
+  DrawUniforms draw;
+
+  // Стадии, ожидающие проверки в finish()
+  struct Stage {
+    unsigned int shader = 0;
+    const char *type = "";
+  };
+  Stage stages[2];
+  bool pending = false;
+  std::uint64_t cacheKey = 0;
+
+  // Описатели uniform-переменных отрисовки (после создания программы)
+  // -----------------------------------------------------------------
+  void resolveDrawUniforms() {
+    draw.model = uniform<glm::mat4>("model");
+    draw.normalMatrix = uniform<glm::mat3>("normalMatrix");
+    draw.posOffset = uniform<glm::vec3>("posOffset");
+    draw.posScale = uniform<glm::vec3>("posScale");
+    draw.instancedDraw = uniform<bool>("instancedDraw");
+    draw.indirectDraw = uniform<bool>("indirectDraw");
+    draw.drawBase = uniform<unsigned int>("drawBase");
+  }
+
+  // Вставка определений после строки #version
+  // -----------------------------------------
+  static std::string insertDefines(std::string code,
+                                   const std::string &defines) {
+    if (defines.empty())
+      return code;
+    std::size_t version = code.find("#version");
+    if (version == std::string::npos)
+      return defines + code;
+    std::size_t line = code.find('\n', version);
+    line = line == std::string::npos ? code.size() : line + 1;
+    code.insert(line, defines);
+    return code;
+  }
+
+  // Проверка на ошибки компиляции/линковки шейдеров (true - без ошибок)
+  // ------------------------------------------------------------------
+  bool checkCompileErrors(unsigned int shader, std::string type) {
     int success; // Переменная для хранения результата
     char infoLog[1024]; // Переменная для хранения лога ошибок
     if (type != "PROGRAM") {
@@ -189,6 +342,7 @@ private:
             << std::endl;
       }
     }
+    return success;
   }
 };
 #endif
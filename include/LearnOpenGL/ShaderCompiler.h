@@ -0,0 +1,81 @@
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные библиотеки
+#include <cstring>
+#include <iostream>
+
+// Параллельная компиляция шейдеров
+// --------------------------------
+// Расширение GL_KHR_parallel_shader_compile (или GL_ARB_...) позволяет
+// драйверу компилировать и линковать программы на своих потоках и
+// опрашивать готовность через GL_COMPLETION_STATUS_KHR без ожидания.
+// Загрузчик GLAD собран только для ядра, поэтому перечисления объявлены
+// здесь, а glMaxShaderCompilerThreadsKHR загружается в init(). Без
+// расширения программа считается готовой сразу: первый запрос статуса
+// ждет окончания компиляции, как и раньше.
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+class ShaderCompiler {
+public:
+  // Глобальный экземпляр
+  static ShaderCompiler &instance() {
+    static ShaderCompiler compiler;
+    return compiler;
+  }
+
+  // Поиск расширения и выбор числа потоков компиляции (вызывается после
+  // загрузки GLAD; ~0u - на усмотрение драйвера)
+  void init(GLADloadfunc load, unsigned int threads = ~0u) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count && !available; i++) {
+      const char *name = reinterpret_cast<const char *>(
+          glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+      available =
+          name && (!std::strcmp(name, "GL_KHR_parallel_shader_compile") ||
+                   !std::strcmp(name, "GL_ARB_parallel_shader_compile"));
+    }
+    if (!available) {
+      std::cout << "INFO::SHADER_COMPILER::PARALLEL_COMPILE_UNAVAILABLE"
+                << std::endl;
+      return;
+    }
+
+    // Функция называется по-разному в KHR и ARB версиях
+    auto maxThreads = reinterpret_cast<MaxThreadsProc>(
+        load("glMaxShaderCompilerThreadsKHR"));
+    if (!maxThreads)
+      maxThreads = reinterpret_cast<MaxThreadsProc>(
+          load("glMaxShaderCompilerThreadsARB"));
+    if (maxThreads)
+      maxThreads(threads);
+  }
+
+  // Доступна ли параллельная компиляция
+  bool parallel() const { return available; }
+
+  // Завершены ли компиляция и линковка программы (без ожидания)
+  bool completed(GLuint program) const {
+    if (!available)
+      return true;
+    GLint status = GL_TRUE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &status);
+    return status == GL_TRUE;
+  }
+
+private:
+  using MaxThreadsProc = void(GLAD_API_PTR *)(GLuint count);
+
+  bool available = false;
+};
+
+#endif
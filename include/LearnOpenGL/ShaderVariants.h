@@ -0,0 +1,131 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+// Остальные библиотеки
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Остальные заголовочные файлы
+#include "Shader.h" // Класс шейдера
+
+// Возможности варианта шейдера
+// ----------------------------
+// Каждый бит - определение препроцессора (#define) в исходном коде
+// варианта; шейдеры проверяют их через #ifdef, поэтому ветви и циклы по
+// отсутствующим источникам и картам исчезают при компиляции.
+/* Сцена */
+constexpr std::uint32_t SHADER_DIR_LIGHT = 1u << 0;    // HAS_DIR_LIGHT
+constexpr std::uint32_t SHADER_POINT_LIGHTS = 1u << 1; // HAS_POINT_LIGHTS
+constexpr std::uint32_t SHADER_SPOT_LIGHT = 1u << 2;   // HAS_SPOT_LIGHT
+constexpr std::uint32_t SHADER_CLUSTERED = 1u << 3; // CLUSTERED_LIGHTING
+/* Материал */
+constexpr std::uint32_t SHADER_SPECULAR_MAP = 1u << 4; // HAS_SPECULAR_MAP
+constexpr std::uint32_t SHADER_NORMAL_MAP = 1u << 5;   // HAS_NORMAL_MAP
+
+constexpr std::uint32_t SHADER_SCENE_FEATURES =
+    SHADER_DIR_LIGHT | SHADER_POINT_LIGHTS | SHADER_SPOT_LIGHT |
+    SHADER_CLUSTERED;
+constexpr std::uint32_t SHADER_MATERIAL_FEATURES =
+    SHADER_SPECULAR_MAP | SHADER_NORMAL_MAP;
+
+// Фильтр отрисовки: меши с любым материалом
+constexpr std::uint32_t ANY_MATERIAL = ~0u;
+
+// Определения препроцессора для набора возможностей
+inline std::string shaderDefines(std::uint32_t features) {
+  static const char *const names[] = {
+      "HAS_DIR_LIGHT",      "HAS_POINT_LIGHTS", "HAS_SPOT_LIGHT",
+      "CLUSTERED_LIGHTING", "HAS_SPECULAR_MAP", "HAS_NORMAL_MAP",
+  };
+  std::string defines;
+  for (std::uint32_t bit = 0; bit < std::size(names); bit++)
+    if (features & (1u << bit))
+      defines += std::string("#define ") + names[bit] + '\n';
+  return defines;
+}
+
+// Варианты шейдера
+// ----------------
+// Программы одной пары исходных файлов с разными наборами возможностей.
+// Вариант компилируется при первом запросе и хранится по ключу - набору
+// возможностей, ограниченному маской тех, что шейдер использует (иначе
+// одинаковые программы компилировались бы под разными ключами).
+// Компиляция не блокирует кадр: пока вариант собирается драйвером
+// (ShaderCompiler.h), get() возвращает готовый запасной вариант - с
+// наибольшим подмножеством запрошенных возможностей (подмножество не
+// требует атрибутов и текстур, которых может не быть у меша). Ждать
+// приходится, только если готового подмножества еще нет.
+class ShaderVariants {
+public:
+  ShaderVariants(const char *vertexPath, const char *fragmentPath,
+                 std::uint32_t supportedFeatures)
+      : vertex(vertexPath), fragment(fragmentPath),
+        supported(supportedFeatures) {}
+
+  // Вариант для набора возможностей (компилируется при первом запросе;
+  // до готовности заменяется запасным)
+  Shader &get(std::uint32_t features) {
+    std::uint32_t key = features & supported;
+    Shader &shader = request(key);
+    if (shader.ready())
+      return shader;
+
+    // Готовый вариант с наибольшим подмножеством возможностей
+    Shader *fallback = nullptr;
+    int fallbackBits = -1;
+    for (auto &[other, variant] : variants) {
+      if ((other & ~key) || std::popcount(other) <= fallbackBits ||
+          !variant->ready())
+        continue;
+      fallback = variant.get();
+      fallbackBits = std::popcount(other);
+    }
+    if (fallback)
+      return *fallback;
+    shader.finish();
+    return shader;
+  }
+
+  // Запуск компиляции варианта заранее (без ожидания)
+  void prefetch(std::uint32_t features) { request(features & supported); }
+
+  // Число вариантов (всего и еще компилируемых)
+  std::size_t size() const { return variants.size(); }
+  std::size_t pending() {
+    std::size_t count = 0;
+    for (auto &[key, shader] : variants)
+      count += !shader->ready();
+    return count;
+  }
+
+  // Удаление программ (до уничтожения контекста)
+  void release() {
+    for (auto &[key, shader] : variants)
+      shader->deleteProgram();
+    variants.clear();
+  }
+
+private:
+  std::string vertex, fragment;
+  std::uint32_t supported;
+  std::unordered_map<std::uint32_t, std::unique_ptr<Shader>> variants;
+
+  // Вариант по ключу; новый запускается на компиляцию без ожидания
+  Shader &request(std::uint32_t key) {
+    auto it = variants.find(key);
+    if (it != variants.end())
+      return *it->second;
+    std::cout << "INFO::SHADER::COMPILING_VARIANT " << fragment << " 0x"
+              << std::hex << key << std::dec << std::endl;
+    auto shader = std::make_unique<Shader>(vertex.c_str(), fragment.c_str(),
+                                           shaderDefines(key), true);
+    return *variants.emplace(key, std::move(shader)).first->second;
+  }
+};
+
+#endif
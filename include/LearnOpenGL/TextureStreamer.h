@@ -0,0 +1,604 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+// GLAD
+#include "glad/gl.h"
+
+// STB
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+// Остальные библиотеки
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "BlockCompression.h" // Блочное сжатие
+#include "GLState.h"          // Кеш состояния OpenGL
+#include "Hash.h"             // Хеширование
+#include "Ktx2.h"             // Контейнер KTX2
+#include "ThreadPool.h"       // Пул рабочих потоков
+
+// Форматы S3TC (расширение GL_EXT_texture_compression_s3tc)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// Назначение текстуры (определяет формат сжатия)
+// ----------------------------------------------
+// Diffuse - BC1 (BC3 при наличии альфы), Specular - BC4 (канал R
+// размножается в RGB swizzle-маской), Normal - BC5 (шейдер восстанавливает
+// z = sqrt(1 - x^2 - y^2)). Color не сжимается.
+enum class TextureRole { Color, Diffuse, Specular, Normal };
+
+// Асинхронная загрузка текстур
+// ----------------------------
+// load() сразу возвращает имя текстуры. Декодирование выполняется на
+// рабочих потоках, результат копируется в постоянно отображенный
+// PIXEL_UNPACK буфер (кольцо), а поток контекста в update() каждый кадр
+// загружает в текстуры не больше uploadBudget байт. Участки кольца
+// освобождаются только после срабатывания fence соответствующей загрузки.
+// Пока текстура не загружена, resolve() возвращает текстуру-заглушку.
+//
+// Текстуры с назначением Diffuse/Specular/Normal при первой загрузке
+// сжимаются в BCn вместе со всеми mip-уровнями и сохраняются рядом с
+// исходным файлом (<path>.ktx2); при следующих запусках готовые уровни
+// читаются из KTX2 и загружаются glCompressedTextureSubImage2D.
+class TextureStreamer {
+public:
+  // Бюджет загрузки в GPU за кадр (байт). Одна текстура за кадр загружается
+  // всегда, даже если она больше бюджета
+  std::size_t uploadBudget = 4 * 1024 * 1024;
+  // Блочное сжатие текстур с назначением (до загрузки первой текстуры)
+  bool compressTextures = true;
+
+  // Глобальный экземпляр
+  static TextureStreamer &instance() {
+    static TextureStreamer streamer;
+    return streamer;
+  }
+
+  // Инициализация (требует текущий контекст OpenGL)
+  void init(std::size_t ringSize = 64 * 1024 * 1024) {
+    if (initialized)
+      return;
+    initialized = true;
+    ringCapacity = ringSize;
+
+    // Кольцевой буфер загрузки
+    glCreateBuffers(1, &ringBuffer);
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glNamedBufferStorage(ringBuffer, static_cast<GLsizeiptr>(ringCapacity),
+                         nullptr, flags);
+    ringMemory = static_cast<unsigned char *>(glMapNamedBufferRange(
+        ringBuffer, 0, static_cast<GLsizeiptr>(ringCapacity), flags));
+
+    // Заглушка (серый пиксель)
+    const unsigned char grey[4] = {128, 128, 128, 255};
+    glCreateTextures(GL_TEXTURE_2D, 1, &placeholder);
+    glTextureStorage2D(placeholder, 1, GL_RGBA8, 1, 1);
+    glTextureSubImage2D(placeholder, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                        grey);
+
+    // BC4/BC5 (RGTC) входят в ядро, BC1/BC3 (S3TC) - расширение
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++) {
+      std::string extension = reinterpret_cast<const char *>(
+          glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+      if (extension == "GL_EXT_texture_compression_s3tc")
+        s3tcSupported = true;
+      else if (extension == "GL_EXT_texture_sRGB" ||
+               extension == "GL_EXT_texture_compression_s3tc_srgb")
+        s3tcSrgbSupported = true;
+    }
+    s3tcSrgbSupported = s3tcSrgbSupported && s3tcSupported;
+  }
+
+  // Запрос загрузки текстуры из файла
+  unsigned int load(const std::string &filename, bool gamma = false,
+                    TextureRole role = TextureRole::Color) {
+    init();
+
+    unsigned int texture;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    if (states.size() <= texture)
+      states.resize(texture + 1, State::Empty);
+    states[texture] = State::Pending;
+
+    auto job = std::make_shared<Job>();
+    job->texture = texture;
+    job->path = filename;
+    job->gamma = gamma;
+    job->role = compressTextures ? role : TextureRole::Color;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      activeJobs++;
+    }
+    ThreadPool::global().submit([this, job] {
+      decode(*job);
+      // Уведомление под мьютексом: после activeJobs == 0 поток контекста
+      // может завершить работу стримера
+      std::lock_guard<std::mutex> lock(mutex);
+      ready.push_back(job);
+      activeJobs--;
+      ringCondition.notify_all();
+    });
+    return texture;
+  }
+
+  // Текстура для привязки: сама текстура или заглушка, пока она не загружена
+  unsigned int resolve(unsigned int texture) const {
+    return texture < states.size() && states[texture] == State::Resident
+               ? texture
+               : placeholder;
+  }
+
+  // Удаление текстуры. Если текстура еще декодируется, она будет удалена
+  // при получении результата, чтобы ее имя не было переиспользовано раньше
+  void unload(unsigned int texture) {
+    if (texture < states.size() && states[texture] == State::Pending) {
+      states[texture] = State::Cancelled;
+      return;
+    }
+    GLState::instance().deleteTextures(1, &texture);
+    if (texture < states.size())
+      states[texture] = State::Empty;
+  }
+
+  // Количество текстур, ожидающих загрузки
+  std::size_t pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return activeJobs + ready.size();
+  }
+
+  // Загрузка готовых текстур и освобождение кольца (раз в кадр)
+  void update() {
+    if (!initialized)
+      return;
+    retireUploads();
+
+    std::size_t uploaded = 0;
+    for (;;) {
+      std::shared_ptr<Job> job;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ready.empty() || (uploaded > 0 && uploaded >= uploadBudget))
+          break;
+        job = ready.front();
+        ready.pop_front();
+      }
+      uploaded += upload(*job);
+    }
+  }
+
+  // Завершение работы (до уничтожения контекста)
+  void shutdown() {
+    if (!initialized)
+      return;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      stopping = true;
+      ringCondition.notify_all();
+      ringCondition.wait(lock, [this] { return activeJobs == 0; });
+      ready.clear();
+    }
+    for (Region &region : regions)
+      if (region.fence)
+        glDeleteSync(region.fence);
+    regions.clear();
+    glUnmapNamedBuffer(ringBuffer);
+    GLState::instance().deleteBuffers(1, &ringBuffer);
+    GLState::instance().deleteTextures(1, &placeholder);
+    initialized = false;
+  }
+
+private:
+  // Сжатый mip-уровень
+  struct Level {
+    std::size_t offset;
+    std::size_t size;
+    int width;
+    int height;
+  };
+
+  // Задание на загрузку
+  struct Job {
+    unsigned int texture = 0;
+    std::string path;
+    bool gamma = false;
+    TextureRole role = TextureRole::Color;
+    // Результат декодирования
+    int width = 0, height = 0, components = 0;
+    std::size_t size = 0;
+    std::size_t offset = 0;          // Смещение в кольце
+    bool inRing = false;             // Данные лежат в кольце
+    std::vector<unsigned char> data; // Данные, не поместившиеся в кольцо
+    bool failed = false;
+    // Сжатая текстура: уровни (смещения относительно начала данных)
+    bool compressed = false;
+    BlockCompression::Format format = BlockCompression::Format::BC1;
+    std::vector<Level> levels;
+    double psnr = 0.0; // Качество сжатия (0, если уровни взяты из KTX2)
+  };
+
+  // Занятый участок кольца
+  struct Region {
+    std::size_t offset;
+    std::size_t size;
+    bool uploaded = false;
+    GLsync fence = nullptr;
+  };
+
+  bool initialized = false;
+  unsigned int ringBuffer = 0;
+  unsigned char *ringMemory = nullptr;
+  std::size_t ringCapacity = 0;
+  std::size_t ringHead = 0;
+  unsigned int placeholder = 0;
+  bool s3tcSupported = false;
+  bool s3tcSrgbSupported = false;
+  // Состояние текстур по имени (только поток контекста)
+  enum class State : unsigned char { Empty, Pending, Resident, Cancelled };
+  std::vector<State> states;
+
+  mutable std::mutex mutex;
+  std::condition_variable ringCondition;
+  std::deque<Region> regions; // В порядке выделения
+  std::deque<std::shared_ptr<Job>> ready;
+  std::size_t activeJobs = 0;
+  bool stopping = false;
+
+  TextureStreamer() = default;
+
+  // Декодирование на рабочем потоке
+  // -------------------------------
+  void decode(Job &job) {
+    stbi_set_flip_vertically_on_load_thread(true);
+    if (!stbi_info(job.path.c_str(), &job.width, &job.height,
+                   &job.components) ||
+        job.components < 1 || job.components > 4) {
+      job.failed = true;
+      return;
+    }
+    if (chooseFormat(job)) {
+      decodeCompressed(job);
+      return;
+    }
+    if (job.components == 2) {
+      job.failed = true;
+      return;
+    }
+    job.size = static_cast<std::size_t>(job.width) *
+               static_cast<std::size_t>(job.height) *
+               static_cast<std::size_t>(job.components);
+
+    // Место в кольце выделяется до декодирования, чтобы ожидание свободного
+    // участка не держало в памяти распакованное изображение
+    job.inRing = allocate(job.size, job.offset);
+
+    int width, height, components;
+    unsigned char *pixels =
+        stbi_load(job.path.c_str(), &width, &height, &components, 0);
+    if (!pixels || width != job.width || height != job.height ||
+        components != job.components) {
+      job.failed = true;
+    } else if (job.inRing) {
+      std::memcpy(ringMemory + job.offset, pixels, job.size);
+    } else {
+      job.data.assign(pixels, pixels + job.size);
+    }
+    stbi_image_free(pixels);
+
+    // Участок, в который ничего не будет загружено, освобождается сразу
+    if (job.failed && job.inRing) {
+      std::lock_guard<std::mutex> lock(mutex);
+      findRegion(job.offset).uploaded = true;
+    }
+  }
+
+  // Выбор формата сжатия по назначению текстуры
+  bool chooseFormat(Job &job) const {
+    using BlockCompression::Format;
+    switch (job.role) {
+    case TextureRole::Color:
+      return false;
+    case TextureRole::Diffuse:
+      if (!s3tcSupported || (job.gamma && !s3tcSrgbSupported))
+        return false;
+      // Альфа-канал есть у изображений с 2 и 4 компонентами
+      job.format = job.components % 2 == 0 ? Format::BC3 : Format::BC1;
+      break;
+    case TextureRole::Specular:
+      job.format = Format::BC4;
+      break;
+    case TextureRole::Normal:
+      job.format = Format::BC5;
+      break;
+    }
+    job.compressed = true;
+    return true;
+  }
+
+  // Получение сжатых уровней из KTX2 или сжатие исходного изображения
+  void decodeCompressed(Job &job) {
+    std::uint64_t sourceHash = hashFile(job.path);
+    bool srgb = job.gamma && job.role == TextureRole::Diffuse;
+    std::uint32_t vkFormat = Ktx2::vkFormat(job.format, srgb);
+    std::string cachePath = job.path + ".ktx2";
+
+    std::vector<std::vector<std::uint8_t>> encoded;
+    Ktx2::Reader reader;
+    std::vector<std::span<const std::uint8_t>> levels;
+    if (sourceHash && reader.open(cachePath, vkFormat, sourceHash)) {
+      job.width = reader.width();
+      job.height = reader.height();
+      for (std::size_t i = 0; i < reader.levelCount(); i++)
+        levels.push_back(reader.level(i));
+    } else {
+      int components;
+      unsigned char *pixels = stbi_load(job.path.c_str(), &job.width,
+                                        &job.height, &components, 4);
+      if (!pixels) {
+        job.failed = true;
+        return;
+      }
+      BlockCompression::Image source;
+      source.width = job.width;
+      source.height = job.height;
+      std::size_t sourceSize = static_cast<std::size_t>(job.width) *
+                               static_cast<std::size_t>(job.height) * 4;
+      source.pixels.assign(pixels, pixels + sourceSize);
+      stbi_image_free(pixels);
+
+      std::vector<BlockCompression::Image> chain =
+          BlockCompression::buildMipChain(std::move(source), srgb);
+      for (const BlockCompression::Image &image : chain)
+        encoded.push_back(BlockCompression::encode(image, job.format));
+      job.psnr = BlockCompression::psnr(
+          chain[0],
+          BlockCompression::decode(encoded[0].data(), job.width, job.height,
+                                   job.format),
+          job.format);
+      if (sourceHash)
+        Ktx2::write(cachePath, job.format, srgb, job.width, job.height,
+                    encoded, sourceHash);
+      for (const auto &level : encoded)
+        levels.push_back(level);
+    }
+
+    // Раскладка уровней (сжатые уровни кратны 8 байтам)
+    job.size = 0;
+    for (std::size_t i = 0; i < levels.size(); i++) {
+      job.levels.push_back({job.size, levels[i].size(),
+                            std::max(1, job.width >> i),
+                            std::max(1, job.height >> i)});
+      job.size += levels[i].size();
+    }
+
+    job.inRing = allocate(job.size, job.offset);
+    unsigned char *dst;
+    if (job.inRing) {
+      dst = ringMemory + job.offset;
+    } else {
+      job.data.resize(job.size);
+      dst = job.data.data();
+    }
+    for (std::size_t i = 0; i < levels.size(); i++)
+      std::memcpy(dst + job.levels[i].offset, levels[i].data(),
+                  levels[i].size());
+  }
+
+  // Выделение участка кольца (ожидает освобождения места)
+  bool allocate(std::size_t size, std::size_t &offset) {
+    // Участки выравниваются по 4 байта
+    size = (size + 3) & ~std::size_t(3);
+    if (size >= ringCapacity)
+      return false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      if (stopping)
+        return false;
+      if (regions.empty())
+        ringHead = 0;
+      std::size_t tail = regions.empty() ? 0 : regions.front().offset;
+      bool wrapped = !regions.empty() && ringHead <= tail;
+      // Равенство ringHead и tail при непустом кольце означает
+      // заполненность, поэтому выделение никогда не догоняет хвост вплотную
+      if (!wrapped && ringHead + size <= ringCapacity) {
+        offset = ringHead;
+        break;
+      }
+      if (!wrapped && size < tail) {
+        offset = 0;
+        break;
+      }
+      if (wrapped && ringHead + size < tail) {
+        offset = ringHead;
+        break;
+      }
+      ringCondition.wait(lock);
+    }
+    ringHead = offset + size;
+    regions.push_back({offset, size});
+    return true;
+  }
+
+  // Участок кольца по смещению (под мьютексом)
+  Region &findRegion(std::size_t offset) {
+    return *std::find_if(regions.begin(), regions.end(),
+                         [offset](const Region &r) {
+                           return r.offset == offset;
+                         });
+  }
+
+  // Освобождение участков, загрузка из которых завершилась на GPU
+  void retireUploads() {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool freed = false;
+    while (!regions.empty() && regions.front().uploaded) {
+      Region &front = regions.front();
+      if (front.fence) {
+        if (glClientWaitSync(front.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+          break;
+        glDeleteSync(front.fence);
+      }
+      regions.pop_front();
+      freed = true;
+    }
+    if (freed)
+      ringCondition.notify_all();
+  }
+
+  // Загрузка декодированной текстуры в GPU (поток контекста)
+  // --------------------------------------------------------
+  std::size_t upload(const Job &job) {
+    if (states[job.texture] == State::Cancelled) {
+      GLState::instance().deleteTextures(1, &job.texture);
+      states[job.texture] = State::Empty;
+      if (job.inRing && !job.failed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        findRegion(job.offset).uploaded = true;
+      }
+      return 0;
+    }
+    if (job.failed) {
+      std::cout << "Texture failed to load at path: " << job.path << std::endl;
+      states[job.texture] = State::Empty;
+      return 0;
+    }
+
+    if (job.compressed)
+      return uploadCompressed(job);
+
+    GLenum internalFormat;
+    GLenum format;
+    if (job.components == 1) {
+      internalFormat = GL_R8;
+      format = GL_RED;
+    } else if (job.components == 3) {
+      internalFormat = job.gamma ? GL_SRGB8 : GL_RGB8;
+      format = GL_RGB;
+    } else {
+      internalFormat = job.gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+      format = GL_RGBA;
+    }
+
+    // Полная цепочка mip-уровней
+    int levels = 1;
+    while ((std::max(job.width, job.height) >> levels) > 0)
+      levels++;
+
+    glTextureStorage2D(job.texture, levels, internalFormat, job.width,
+                       job.height);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (job.inRing) {
+      GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, ringBuffer);
+      glTextureSubImage2D(job.texture, 0, 0, 0, job.width, job.height, format,
+                          GL_UNSIGNED_BYTE,
+                          reinterpret_cast<const void *>(job.offset));
+      GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    } else {
+      glTextureSubImage2D(job.texture, 0, 0, 0, job.width, job.height, format,
+                          GL_UNSIGNED_BYTE, job.data.data());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateTextureMipmap(job.texture);
+
+    finishUpload(job);
+    return job.size;
+  }
+
+  // Загрузка сжатых уровней
+  std::size_t uploadCompressed(const Job &job) {
+    using BlockCompression::Format;
+    GLenum internalFormat = 0;
+    switch (job.format) {
+    case Format::BC1:
+      internalFormat = job.gamma ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+                                 : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      break;
+    case Format::BC3:
+      internalFormat = job.gamma ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+                                 : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      break;
+    case Format::BC4:
+      internalFormat = GL_COMPRESSED_RED_RGTC1;
+      break;
+    case Format::BC5:
+      internalFormat = GL_COMPRESSED_RG_RGTC2;
+      break;
+    }
+    if (job.psnr > 0.0)
+      std::cout << "Texture compressed: " << job.path << " (PSNR " << job.psnr
+                << " dB)" << std::endl;
+
+    glTextureStorage2D(job.texture, static_cast<GLsizei>(job.levels.size()),
+                       internalFormat, job.width, job.height);
+    const unsigned char *base = job.data.data();
+    if (job.inRing) {
+      GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, ringBuffer);
+      base = nullptr;
+    }
+    for (std::size_t i = 0; i < job.levels.size(); i++) {
+      const Level &level = job.levels[i];
+      std::size_t offset = (job.inRing ? job.offset : 0) + level.offset;
+      glCompressedTextureSubImage2D(
+          job.texture, static_cast<GLint>(i), 0, 0, level.width, level.height,
+          internalFormat, static_cast<GLsizei>(level.size),
+          base ? base + offset : reinterpret_cast<const void *>(offset));
+    }
+    if (job.inRing)
+      GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Одноканальная карта бликов читается в шейдере как .rgb
+    if (job.format == Format::BC4) {
+      const GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+      glTextureParameteriv(job.texture, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    finishUpload(job);
+    return job.size;
+  }
+
+  // Параметры выборки и fence для освобождения участка кольца
+  void finishUpload(const Job &job) {
+    glTextureParameteri(job.texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(job.texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTextureParameteri(job.texture, GL_TEXTURE_MIN_FILTER,
+                        GL_LINEAR_MIPMAP_LINEAR);
+    glTextureParameteri(job.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if (job.inRing) {
+      GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      std::lock_guard<std::mutex> lock(mutex);
+      Region &region = findRegion(job.offset);
+      region.fence = fence;
+      region.uploaded = true;
+    }
+    states[job.texture] = State::Resident;
+  }
+};
+
+#endif
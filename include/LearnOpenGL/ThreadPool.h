@@ -0,0 +1,125 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Остальные библиотеки
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул рабочих потоков
+// -------------------
+// Потоки пула не владеют контекстом OpenGL: в задачах допустима только работа
+// с памятью и файлами, все вызовы GL остаются на потоке контекста
+class ThreadPool {
+public:
+  // Общий пул процесса (один поток оставляется потоку контекста)
+  static ThreadPool &global() {
+    unsigned int cores = std::thread::hardware_concurrency();
+    static ThreadPool pool(cores > 1 ? cores - 1 : 1);
+    return pool;
+  }
+
+  explicit ThreadPool(unsigned int threadCount) {
+    for (unsigned int i = 0; i < threadCount; i++)
+      workers.emplace_back([this] { workerLoop(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    condition.notify_all();
+    for (std::thread &worker : workers)
+      worker.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Количество рабочих потоков
+  std::size_t size() const { return workers.size(); }
+
+  // Постановка задачи в очередь
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+  }
+
+  // Параллельное выполнение func(i) для i в [0, count)
+  // Вызывающий поток участвует в работе и возвращается после завершения всех
+  // итераций. Порядок выполнения итераций не определен, поэтому каждая
+  // итерация должна писать только в свой элемент результата.
+  // Ожидаются итерации, а не вспомогательные задачи: если рабочие потоки
+  // заняты долгими задачами, вызывающий поток выполнит все итерации сам, а
+  // запоздавшие вспомогательные задачи завершатся, ничего не сделав
+  template <typename Func> void parallelFor(std::size_t count, Func &&func) {
+    if (count == 0)
+      return;
+
+    struct State {
+      std::atomic<std::size_t> next = 0;
+      std::atomic<std::size_t> finished = 0;
+      std::size_t count = 0;
+      std::function<void(std::size_t)> func;
+      std::mutex mutex;
+      std::condition_variable condition;
+
+      void run() {
+        for (std::size_t i = next++; i < count; i = next++) {
+          func(i);
+          if (++finished == count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            condition.notify_all();
+          }
+        }
+      }
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->func = std::ref(func);
+
+    std::size_t helpers = std::min(workers.size(), count - 1);
+    for (std::size_t i = 0; i < helpers; i++)
+      submit([state] { state->run(); });
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock,
+                          [&state] { return state->finished == state->count; });
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool stopping = false;
+
+  void workerLoop() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (stopping && tasks.empty())
+          return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+};
+
+#endif
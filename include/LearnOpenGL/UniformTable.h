@@ -0,0 +1,307 @@
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+// GLAD
+#include "glad/gl.h"
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "Hash.h" // Хеширование
+
+// Таблица uniform-переменных программы
+// ------------------------------------
+// После линковки активные uniform-переменные перечисляются через
+// glGetProgramResource* (элементы массивов - под именами name[i]) и
+// раскладываются в минимальную идеальную хеш-таблицу (hash and displace):
+// поиск имени - один хеш строки, одно перемешивание и одно сравнение, без
+// обращений к драйверу. Для каждой переменной хранится копия последнего
+// загруженного значения, поэтому повторная загрузка того же значения
+// пропускается. Имена одной location (массив "name" и "name[0]") делят
+// одну копию, иначе загрузка через одно имя оставила бы копию другого
+// устаревшей.
+class UniformTable {
+public:
+  static constexpr std::uint32_t NOT_FOUND = ~0u;
+  // Максимальный размер копии значения (mat4)
+  static constexpr std::size_t MAX_VALUE_SIZE = sizeof(glm::mat4);
+
+  // Переменная
+  struct Entry {
+    std::string name;
+    std::uint64_t hash;
+    GLint location;
+    GLenum type;
+    std::uint32_t shadow; // Индекс копии значения (общей для location)
+  };
+
+  // Перечисление активных uniform-переменных программы
+  void reflect(GLuint program) {
+    entries.clear();
+    shadows.clear();
+    reflections++;
+    GLint count = 0, maxLength = 0;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH,
+                            &maxLength);
+    std::vector<char> buffer(std::size_t(std::max(maxLength, 1)));
+    const GLenum properties[] = {GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE};
+    for (GLint i = 0; i < count; i++) {
+      GLint values[3] = {};
+      glGetProgramResourceiv(program, GL_UNIFORM, GLuint(i), 3, properties, 3,
+                             nullptr, values);
+      // Переменные из uniform-блоков не имеют location
+      if (values[0] < 0)
+        continue;
+      GLsizei length = 0;
+      glGetProgramResourceName(program, GL_UNIFORM, GLuint(i), maxLength,
+                               &length, buffer.data());
+      std::string name(buffer.data(), std::size_t(length));
+      add(name, values[0], GLenum(values[1]));
+
+      // Массив: имя без [0] и все элементы name[i]
+      if (name.size() > 3 && name.ends_with("[0]")) {
+        std::string base = name.substr(0, name.size() - 3);
+        add(base, values[0], GLenum(values[1]));
+        for (GLint e = 1; e < values[2]; e++) {
+          std::string element = base + '[' + std::to_string(e) + ']';
+          add(element, glGetUniformLocation(program, element.c_str()),
+              GLenum(values[1]));
+        }
+      }
+    }
+    build();
+  }
+
+  // Индекс переменной (NOT_FOUND, если переменной нет)
+  std::uint32_t find(std::string_view name) const {
+    if (slots.empty())
+      return NOT_FOUND;
+    std::uint64_t hash = hashString(name);
+    std::uint32_t seed = seeds[hash % seeds.size()];
+    std::uint32_t index = slots[mix(hash, seed) & (slots.size() - 1)];
+    if (index == NOT_FOUND || entries[index].hash != hash ||
+        entries[index].name != name)
+      return NOT_FOUND;
+    return index;
+  }
+
+  const Entry &operator[](std::uint32_t index) const { return entries[index]; }
+  std::size_t size() const { return entries.size(); }
+  // Номер перечисления: меняется при каждом reflect(), после чего индексы
+  // переменных недействительны
+  std::uint32_t generation() const { return reflections; }
+
+  // Запоминание значения; false, если оно совпадает с загруженным ранее
+  template <typename T> bool update(std::uint32_t index, const T &value) {
+    static_assert(sizeof(T) <= MAX_VALUE_SIZE &&
+                  std::is_trivially_copyable_v<T>);
+    Shadow &shadow = shadows[entries[index].shadow];
+    if (shadow.size == sizeof(T) &&
+        std::memcmp(shadow.value, &value, sizeof(T)) == 0)
+      return false;
+    std::memcpy(shadow.value, &value, sizeof(T));
+    shadow.size = sizeof(T);
+    return true;
+  }
+
+private:
+  // Копия последнего загруженного значения
+  struct Shadow {
+    alignas(16) unsigned char value[MAX_VALUE_SIZE];
+    std::uint8_t size = 0; // 0 - значение еще не загружалось
+  };
+
+  std::vector<Entry> entries;
+  std::vector<Shadow> shadows;
+  std::uint32_t reflections = 0;
+  std::vector<std::uint32_t> seeds; // Смещение (seed) для каждой корзины
+  std::vector<std::uint32_t> slots; // Слот -> индекс переменной
+
+  void add(const std::string &name, GLint location, GLenum type) {
+    if (location < 0)
+      return;
+    Entry entry;
+    entry.name = name;
+    entry.hash = hashString(name);
+    entry.location = location;
+    entry.type = type;
+    // Псевдоним уже добавленной location использует ее копию
+    auto alias = std::find_if(entries.begin(), entries.end(),
+                              [location](const Entry &other) {
+                                return other.location == location;
+                              });
+    if (alias != entries.end()) {
+      entry.shadow = alias->shadow;
+    } else {
+      entry.shadow = static_cast<std::uint32_t>(shadows.size());
+      shadows.emplace_back();
+    }
+    entries.push_back(std::move(entry));
+  }
+
+  // Перемешивание хеша с seed (splitmix64)
+  static std::uint64_t mix(std::uint64_t hash, std::uint32_t seed) {
+    std::uint64_t z = hash + 0x9E3779B97F4A7C15ull * (std::uint64_t(seed) + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  // Построение идеальной хеш-таблицы
+  // Ключи делятся на корзины по hash % seeds.size(); корзины от больших к
+  // меньшим получают seed, при котором все их ключи попадают в свободные
+  // слоты. При неудаче таблица увеличивается вдвое.
+  void build() {
+    std::size_t count = entries.size();
+    seeds.assign(std::max<std::size_t>(count / 2, 1), 0);
+    std::size_t slotCount = std::bit_ceil(std::max<std::size_t>(count, 1));
+    std::vector<std::vector<std::uint32_t>> buckets(seeds.size());
+    for (std::uint32_t i = 0; i < count; i++)
+      buckets[entries[i].hash % seeds.size()].push_back(i);
+    std::vector<std::uint32_t> order(buckets.size());
+    for (std::uint32_t b = 0; b < order.size(); b++)
+      order[b] = b;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::uint32_t a, std::uint32_t b) {
+                       return buckets[a].size() > buckets[b].size();
+                     });
+
+    constexpr std::uint32_t MAX_SEED = 1u << 16;
+    for (;;) {
+      slots.assign(slotCount, NOT_FOUND);
+      bool placed = true;
+      for (std::uint32_t b : order) {
+        std::uint32_t seed = 0;
+        for (; seed < MAX_SEED; seed++)
+          if (tryPlace(buckets[b], seed))
+            break;
+        if (seed == MAX_SEED) {
+          placed = false;
+          break;
+        }
+        seeds[b] = seed;
+      }
+      if (placed)
+        return;
+      slotCount *= 2;
+    }
+  }
+
+  // Размещение корзины с заданным seed (без изменений при неудаче)
+  bool tryPlace(const std::vector<std::uint32_t> &bucket, std::uint32_t seed) {
+    std::size_t mask = slots.size() - 1;
+    std::vector<std::size_t> taken;
+    for (std::uint32_t index : bucket) {
+      std::size_t slot = mix(entries[index].hash, seed) & mask;
+      if (slots[slot] != NOT_FOUND ||
+          std::find(taken.begin(), taken.end(), slot) != taken.end())
+        return false;
+      taken.push_back(slot);
+    }
+    for (std::size_t i = 0; i < bucket.size(); i++)
+      slots[taken[i]] = bucket[i];
+    return true;
+  }
+};
+
+// Загрузка значения uniform-переменной в программу
+// ------------------------------------------------
+namespace detail {
+
+inline void programUniform(GLuint program, GLint location, bool value) {
+  glProgramUniform1i(program, location, (int)value);
+}
+inline void programUniform(GLuint program, GLint location, int value) {
+  glProgramUniform1i(program, location, value);
+}
+inline void programUniform(GLuint program, GLint location,
+                           unsigned int value) {
+  glProgramUniform1ui(program, location, value);
+}
+inline void programUniform(GLuint program, GLint location, float value) {
+  glProgramUniform1f(program, location, value);
+}
+inline void programUniform(GLuint program, GLint location,
+                           const glm::vec2 &value) {
+  glProgramUniform2fv(program, location, 1, &value[0]);
+}
+inline void programUniform(GLuint program, GLint location,
+                           const glm::vec3 &value) {
+  glProgramUniform3fv(program, location, 1, &value[0]);
+}
+inline void programUniform(GLuint program, GLint location,
+                           const glm::vec4 &value) {
+  glProgramUniform4fv(program, location, 1, &value[0]);
+}
+inline void programUniform(GLuint program, GLint location,
+                           const glm::mat2 &value) {
+  glProgramUniformMatrix2fv(program, location, 1, GL_FALSE, &value[0][0]);
+}
+inline void programUniform(GLuint program, GLint location,
+                           const glm::mat3 &value) {
+  glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, &value[0][0]);
+}
+inline void programUniform(GLuint program, GLint location,
+                           const glm::mat4 &value) {
+  glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, &value[0][0]);
+}
+
+} // namespace detail
+
+// Типизированный описатель uniform-переменной
+// -------------------------------------------
+// Получается один раз (Shader::uniform<T>) и хранится в цикле рендеринга.
+// set() загружает значение через glProgramUniform (программа может быть не
+// привязана), если оно отличается от последнего загруженного. Описатель
+// ссылается на таблицу шейдера и действителен, пока жив шейдер. Индекс
+// переменной ищется заново по имени, если таблица перестроена (например,
+// описатель получен до завершения асинхронной сборки программы).
+template <typename T> class UniformHandle {
+public:
+  UniformHandle() = default;
+  UniformHandle(UniformTable *uniformTable, GLuint programId,
+                std::string_view uniformName)
+      : table(uniformTable), program(programId), name(uniformName) {}
+
+  // Переменная активна в программе
+  bool valid() const {
+    return table && resolve() != UniformTable::NOT_FOUND;
+  }
+
+  void set(const T &value) const {
+    if (!table)
+      return;
+    std::uint32_t entry = resolve();
+    if (entry != UniformTable::NOT_FOUND && table->update(entry, value))
+      detail::programUniform(program, (*table)[entry].location, value);
+  }
+
+private:
+  UniformTable *table = nullptr;
+  GLuint program = 0;
+  std::string name;
+  // Индекс в таблице и номер перечисления, для которого он найден
+  mutable std::uint32_t index = UniformTable::NOT_FOUND;
+  mutable std::uint32_t generation = ~0u;
+
+  std::uint32_t resolve() const {
+    if (generation != table->generation()) {
+      index = table->find(name);
+      generation = table->generation();
+    }
+    return index;
+  }
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef VERTEX_FORMATS_H
+#define VERTEX_FORMATS_H
+
+// GLAD
+#include "glad/gl.h"
+// GLM
+#include <glm/glm.hpp>
+
+// Остальные библиотеки
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Остальные заголовочные файлы
+#include "VertexLayout.h" // Описание формата вершин
+
+#define MAX_BONE_INFLUENCE 4
+
+// Вершина импорта
+// ---------------
+// Полная вершина с float атрибутами; используется только при импорте и
+// оптимизации, в GPU и в кеш мешей попадает один из сжатых форматов ниже
+struct Vertex {
+  glm::vec3 Position;
+  glm::vec3 Normal;
+  glm::vec2 TexCoords;
+  glm::vec3 Tangent;
+  glm::vec3 Bitangent;
+  // bone indexes which will influence this vertex
+  int m_BoneIDs[MAX_BONE_INFLUENCE];
+  // weights from each bone
+  float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// Сжатые форматы вершин
+// ---------------------
+// Position - unorm16 в пределах AABB меша (w - знак битангенса у форматов с
+// касательной), Normal/Tangent - октаэдрическое кодирование snorm16,
+// TexCoords - half float. Location атрибутов одинаковы во всех форматах,
+// поэтому один шейдер рисует меши любого формата (отсутствующие атрибуты
+// читаются как значения по умолчанию).
+enum class VertexFormatId : std::uint32_t {
+  Position,     // Только позиция (источники света, проходы глубины)
+  Unlit,        // Позиция и текстурные координаты
+  Lit,          // + нормаль
+  NormalMapped, // + касательная
+  Skinned,      // + кости
+};
+
+/* Позиция (8 байт) */
+struct VertexPosition {
+  std::uint16_t Position[4];
+};
+
+/* Без освещения (12 байт) */
+struct VertexUnlit {
+  std::uint16_t Position[4];
+  std::uint16_t TexCoords[2];
+};
+
+/* С освещением (16 байт) */
+struct VertexLit {
+  std::uint16_t Position[4];
+  std::int16_t Normal[2];
+  std::uint16_t TexCoords[2];
+};
+
+/* С картой нормалей (20 байт) */
+struct VertexNormalMapped {
+  std::uint16_t Position[4];
+  std::int16_t Normal[2];
+  std::int16_t Tangent[2];
+  std::uint16_t TexCoords[2];
+};
+
+/* С костями (32 байта) */
+struct VertexSkinned {
+  std::uint16_t Position[4];
+  std::int16_t Normal[2];
+  std::int16_t Tangent[2];
+  std::uint16_t TexCoords[2];
+  std::uint16_t BoneIDs[MAX_BONE_INFLUENCE];
+  std::uint8_t Weights[MAX_BONE_INFLUENCE]; // unorm8
+};
+
+/* Деквантование позиций: position = offset + packed * scale */
+struct VertexQuantization {
+  glm::vec3 offset;
+  glm::vec3 scale;
+};
+
+// Атрибуты форматов
+// -----------------
+// Location: 0 - позиция, 1 - нормаль, 2 - текстурные координаты,
+// 3 - касательная, 5 - индексы костей, 6 - веса костей
+template <> struct VertexFormat<VertexPosition> {
+  static constexpr VertexFormatId id = VertexFormatId::Position;
+  static constexpr std::array<VertexAttribute, 1> attributes = {{
+      {0, 4, GL_UNSIGNED_SHORT, GL_TRUE, false,
+       offsetof(VertexPosition, Position)},
+  }};
+};
+
+template <> struct VertexFormat<VertexUnlit> {
+  static constexpr VertexFormatId id = VertexFormatId::Unlit;
+  static constexpr std::array<VertexAttribute, 2> attributes = {{
+      {0, 4, GL_UNSIGNED_SHORT, GL_TRUE, false,
+       offsetof(VertexUnlit, Position)},
+      {2, 2, GL_HALF_FLOAT, GL_FALSE, false, offsetof(VertexUnlit, TexCoords)},
+  }};
+};
+
+template <> struct VertexFormat<VertexLit> {
+  static constexpr VertexFormatId id = VertexFormatId::Lit;
+  static constexpr std::array<VertexAttribute, 3> attributes = {{
+      {0, 4, GL_UNSIGNED_SHORT, GL_TRUE, false, offsetof(VertexLit, Position)},
+      {1, 2, GL_SHORT, GL_TRUE, false, offsetof(VertexLit, Normal)},
+      {2, 2, GL_HALF_FLOAT, GL_FALSE, false, offsetof(VertexLit, TexCoords)},
+  }};
+};
+
+template <> struct VertexFormat<VertexNormalMapped> {
+  static constexpr VertexFormatId id = VertexFormatId::NormalMapped;
+  static constexpr std::array<VertexAttribute, 4> attributes = {{
+      {0, 4, GL_UNSIGNED_SHORT, GL_TRUE, false,
+       offsetof(VertexNormalMapped, Position)},
+      {1, 2, GL_SHORT, GL_TRUE, false, offsetof(VertexNormalMapped, Normal)},
+      {2, 2, GL_HALF_FLOAT, GL_FALSE, false,
+       offsetof(VertexNormalMapped, TexCoords)},
+      {3, 2, GL_SHORT, GL_TRUE, false, offsetof(VertexNormalMapped, Tangent)},
+  }};
+};
+
+template <> struct VertexFormat<VertexSkinned> {
+  static constexpr VertexFormatId id = VertexFormatId::Skinned;
+  static constexpr std::array<VertexAttribute, 6> attributes = {{
+      {0, 4, GL_UNSIGNED_SHORT, GL_TRUE, false,
+       offsetof(VertexSkinned, Position)},
+      {1, 2, GL_SHORT, GL_TRUE, false, offsetof(VertexSkinned, Normal)},
+      {2, 2, GL_HALF_FLOAT, GL_FALSE, false,
+       offsetof(VertexSkinned, TexCoords)},
+      {3, 2, GL_SHORT, GL_TRUE, false, offsetof(VertexSkinned, Tangent)},
+      {5, 4, GL_UNSIGNED_SHORT, GL_FALSE, true,
+       offsetof(VertexSkinned, BoneIDs)},
+      {6, 4, GL_UNSIGNED_BYTE, GL_TRUE, false,
+       offsetof(VertexSkinned, Weights)},
+  }};
+};
+
+static_assert(sizeof(VertexPosition) == 8 && sizeof(VertexUnlit) == 12 &&
+              sizeof(VertexLit) == 16 && sizeof(VertexNormalMapped) == 20 &&
+              sizeof(VertexSkinned) == 32);
+
+// Вызов func(std::type_identity<VertexT>{}) для формата по его id
+template <typename Func>
+decltype(auto) visitVertexFormat(VertexFormatId id, Func &&func) {
+  switch (id) {
+  case VertexFormatId::Position:
+    return func(std::type_identity<VertexPosition>{});
+  case VertexFormatId::Unlit:
+    return func(std::type_identity<VertexUnlit>{});
+  case VertexFormatId::Lit:
+    return func(std::type_identity<VertexLit>{});
+  case VertexFormatId::NormalMapped:
+    return func(std::type_identity<VertexNormalMapped>{});
+  case VertexFormatId::Skinned:
+    break;
+  }
+  return func(std::type_identity<VertexSkinned>{});
+}
+
+// Размер вершины формата
+inline std::size_t vertexSize(VertexFormatId id) {
+  auto size = []<typename VertexT>(std::type_identity<VertexT>) {
+    return sizeof(VertexT);
+  };
+  return visitVertexFormat(id, size);
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+// GLAD
+#include "glad/gl.h"
+
+// Остальные библиотеки
+#include <array>
+#include <cstddef>
+#include <utility>
+
+// Описание формата вершин во время компиляции
+// --------------------------------------------
+// Каждый формат вершины специализирует VertexFormat<VertexT> и перечисляет
+// атрибуты в constexpr массиве attributes. setupVertexLayout разворачивает
+// массив в вызовы glVertexArrayAttrib*Format во время компиляции, а
+// validLayout проверяет описание (выход за конец вершины, пересечение
+// атрибутов, повтор location) через static_assert.
+struct VertexAttribute {
+  GLuint location;
+  GLint size;           // Число компонентов
+  GLenum type;          // Тип компонента
+  GLboolean normalized; // Нормализация целых в [0, 1] / [-1, 1]
+  bool integer;         // Целочисленный атрибут (ivec/uvec в шейдере)
+  GLuint offset;
+};
+
+template <typename VertexT> struct VertexFormat;
+
+// Размер компонента атрибута
+constexpr GLuint componentSize(GLenum type) {
+  switch (type) {
+  case GL_BYTE:
+  case GL_UNSIGNED_BYTE:
+    return 1;
+  case GL_SHORT:
+  case GL_UNSIGNED_SHORT:
+  case GL_HALF_FLOAT:
+    return 2;
+  default:
+    return 4;
+  }
+}
+
+// Проверка описания формата
+template <typename VertexT> constexpr bool validLayout() {
+  constexpr auto &attributes = VertexFormat<VertexT>::attributes;
+  auto end = [](const VertexAttribute &attribute) {
+    return attribute.offset +
+           GLuint(attribute.size) * componentSize(attribute.type);
+  };
+  for (std::size_t i = 0; i < attributes.size(); i++) {
+    const VertexAttribute &a = attributes[i];
+    if (a.offset % 4 != 0 || end(a) > sizeof(VertexT))
+      return false;
+    for (std::size_t j = 0; j < i; j++) {
+      const VertexAttribute &b = attributes[j];
+      // Повтор location или пересечение байтов [offset, end)
+      if (b.location == a.location ||
+          (a.offset < end(b) && b.offset < end(a)))
+        return false;
+    }
+  }
+  return true;
+}
+
+namespace detail {
+
+template <VertexAttribute A>
+void setupAttribute(GLuint vao, GLuint binding, GLuint offset = A.offset) {
+  if constexpr (A.integer)
+    glVertexArrayAttribIFormat(vao, A.location, A.size, A.type, offset);
+  else
+    glVertexArrayAttribFormat(vao, A.location, A.size, A.type, A.normalized,
+                              offset);
+  glVertexArrayAttribBinding(vao, A.location, binding);
+  glEnableVertexArrayAttrib(vao, A.location);
+}
+
+} // namespace detail
+
+// Настройка атрибутов формата VertexT на точке привязки binding
+template <typename VertexT>
+void setupVertexLayout(GLuint vao, GLuint binding) {
+  static_assert(validLayout<VertexT>(), "invalid vertex layout");
+  constexpr auto &attributes = VertexFormat<VertexT>::attributes;
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (detail::setupAttribute<attributes[I]>(vao, binding), ...);
+  }(std::make_index_sequence<attributes.size()>{});
+}
+
+// Настройка атрибутов VertexT в двух потоках
+// ------------------------------------------
+// Позиция (первый атрибут, формат PositionT) читается с positionBinding,
+// остальные атрибуты - с attributeBinding, где вершина хранится без первых
+// sizeof(PositionT) байт. Проходы глубины читают только первый поток.
+template <typename VertexT, typename PositionT>
+void setupSplitVertexLayout(GLuint vao, GLuint positionBinding,
+                            GLuint attributeBinding) {
+  static_assert(validLayout<VertexT>(), "invalid vertex layout");
+  constexpr auto &attributes = VertexFormat<VertexT>::attributes;
+  constexpr auto &position = VertexFormat<PositionT>::attributes;
+  static_assert(position.size() == 1 && attributes[0].offset == 0 &&
+                    attributes[0].location == position[0].location,
+                "position must be the first attribute");
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    static_assert(((I == 0 || attributes[I].offset >= sizeof(PositionT)) &&
+                   ...),
+                  "attribute overlaps the position stream");
+    (detail::setupAttribute<attributes[I]>(
+         vao, I == 0 ? positionBinding : attributeBinding,
+         I == 0 ? 0 : attributes[I].offset - GLuint(sizeof(PositionT))),
+     ...);
+  }(std::make_index_sequence<attributes.size()>{});
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef VERTEX_PACKING_H
+#define VERTEX_PACKING_H
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+// Остальные заголовочные файлы
+#include "VertexFormats.h" // Форматы вершин
+
+// Упаковка вершин
+// ---------------
+// Переводит вершины импорта (Vertex, 88 байт) в один из сжатых форматов
+// (8-32 байта, см. VertexFormats.h). Обратные преобразования выполняет
+// вершинный шейдер.
+namespace VertexPacking {
+
+// Нормализованные целые
+inline std::uint16_t unorm16(float value) {
+  return static_cast<std::uint16_t>(
+      std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+}
+
+inline std::int16_t snorm16(float value) {
+  return static_cast<std::int16_t>(
+      std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+inline std::uint8_t unorm8(float value) {
+  return static_cast<std::uint8_t>(
+      std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+}
+
+// Октаэдрическое кодирование единичного вектора
+// Cigolle et al., "A Survey of Efficient Representations for Independent
+// Unit Vectors" (2014). Нулевой вектор кодируется как (0, 0, 1).
+inline glm::vec2 octEncode(const glm::vec3 &v) {
+  float sum = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+  if (sum == 0.f)
+    return glm::vec2(0.f);
+  glm::vec3 n = v / sum;
+  if (n.z >= 0.f)
+    return glm::vec2(n.x, n.y);
+  auto signNotZero = [](float value) { return value >= 0.f ? 1.f : -1.f; };
+  return glm::vec2((1.f - std::abs(n.y)) * signNotZero(n.x),
+                   (1.f - std::abs(n.x)) * signNotZero(n.y));
+}
+
+inline glm::vec3 octDecode(const glm::vec2 &e) {
+  glm::vec3 n(e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y));
+  float t = std::max(-n.z, 0.f);
+  n.x += n.x >= 0.f ? -t : t;
+  n.y += n.y >= 0.f ? -t : t;
+  return glm::normalize(n);
+}
+
+// Упаковка вершин меша
+// --------------------
+// Позиции квантуются в пределах AABB меша; возвращаемые параметры
+// деквантования передаются шейдеру. Заполняются только атрибуты, которые
+// есть в формате VertexT.
+template <typename VertexT>
+VertexQuantization pack(std::span<const Vertex> vertices,
+                        std::span<VertexT> packed) {
+  VertexQuantization quantization{glm::vec3(0.f), glm::vec3(0.f)};
+  if (vertices.empty())
+    return quantization;
+
+  /* AABB */
+  glm::vec3 minimum = vertices[0].Position, maximum = vertices[0].Position;
+  for (const Vertex &vertex : vertices)
+    for (int c = 0; c < 3; c++) {
+      minimum[c] = std::min(minimum[c], vertex.Position[c]);
+      maximum[c] = std::max(maximum[c], vertex.Position[c]);
+    }
+  quantization.offset = minimum;
+  quantization.scale = maximum - minimum;
+
+  for (std::size_t i = 0; i < vertices.size(); i++) {
+    const Vertex &vertex = vertices[i];
+    VertexT &out = packed[i];
+    /* Позиция */
+    for (int c = 0; c < 3; c++)
+      out.Position[c] =
+          quantization.scale[c] > 0.f
+              ? unorm16((vertex.Position[c] - minimum[c]) /
+                        quantization.scale[c])
+              : 0;
+    out.Position[3] = 65535;
+    /* Нормаль */
+    if constexpr (requires { out.Normal; }) {
+      glm::vec2 normal = octEncode(vertex.Normal);
+      out.Normal[0] = snorm16(normal.x);
+      out.Normal[1] = snorm16(normal.y);
+    }
+    /* Касательная и знак битангенса: B = sign * cross(N, T) */
+    if constexpr (requires { out.Tangent; }) {
+      glm::vec2 tangent = octEncode(vertex.Tangent);
+      out.Tangent[0] = snorm16(tangent.x);
+      out.Tangent[1] = snorm16(tangent.y);
+      bool flipped = glm::dot(glm::cross(vertex.Normal, vertex.Tangent),
+                              vertex.Bitangent) < 0.f;
+      out.Position[3] = flipped ? 0 : 65535;
+    }
+    /* Текстурные координаты */
+    if constexpr (requires { out.TexCoords; }) {
+      out.TexCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+      out.TexCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+    }
+    /* Кости */
+    if constexpr (requires { out.BoneIDs; })
+      for (int b = 0; b < MAX_BONE_INFLUENCE; b++) {
+        out.BoneIDs[b] =
+            static_cast<std::uint16_t>(std::max(vertex.m_BoneIDs[b], 0));
+        out.Weights[b] = unorm8(vertex.m_Weights[b]);
+      }
+  }
+  return quantization;
+}
+
+} // namespace VertexPacking
+
+#endif
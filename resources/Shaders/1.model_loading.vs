@@ -1,16 +1,30 @@
 #version 460 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+// Сжатая вершина (VertexFormats.h): позиция в пределах AABB меша,
+// октаэдрическая нормаль
+layout (location = 0) in vec4 aPos;
+layout (location = 1) in vec2 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+// Деквантование позиции: posOffset + aPos.xyz * posScale
+uniform vec3 posOffset;
+uniform vec3 posScale;
+
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Данные кадра (FrameUniforms.h)
+layout (std140, binding = 0) uniform FrameData {
+  mat4 view;
+  mat4 projection;
+  mat4 viewProj;
+  vec4 cameraPos;
+  vec4 time;
+};
 
 void main()
 {
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 position = posOffset + aPos.xyz * posScale;
+    gl_Position = viewProj * model * vec4(position, 1.0);
 }
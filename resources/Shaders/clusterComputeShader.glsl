@@ -0,0 +1,109 @@
+#version 460 core
+// Распределение точечных источников по кластерам (ClusteredLighting.h)
+// Одна рабочая группа - один кластер; потоки группы перебирают источники
+// с шагом gl_WorkGroupSize.x
+layout (local_size_x = 64) in;
+
+// Данные кадра (FrameUniforms.h)
+layout (std140, binding = 0) uniform FrameData {
+  mat4 view;
+  mat4 projection;
+  mat4 viewProj;
+  vec4 cameraPos;
+  vec4 time;
+};
+
+// Точечные источники (LightManager.h)
+struct PointLight {
+  vec3 position;
+  float linear;
+  vec3 ambient;
+  float quadratic;
+  vec3 diffuse;
+  float range;
+  vec3 specular;
+};
+
+layout (std430, binding = 2) readonly buffer PointLightBuffer {
+  uint pointLightCount;
+  PointLight pointLights[];
+};
+
+// Сетка кластеров
+layout (std430, binding = 5) buffer ClusterGrid {
+  uvec4 clusterSize;  // xyz - число кластеров, w - максимум источников
+  vec4 clusterDepth;  // x - near, y - far, z/w - масштаб и смещение среза
+  vec4 clusterScreen; // xy - размер экрана
+  mat4 inverseProjection;
+  uint clusterLightCounts[];
+};
+
+layout (std430, binding = 6) writeonly buffer ClusterIndices {
+  uint clusterLightIndices[];
+};
+
+shared vec3 aabbMin;
+shared vec3 aabbMax;
+shared uint lightCount;
+
+// Точка на луче через точку экрана ndc, лежащая на плоскости z = depth
+vec3 pointAtDepth(vec2 ndc, float depth) {
+  vec4 p = inverseProjection * vec4(ndc, -1.f, 1.f);
+  p.xyz /= p.w;
+  return p.xyz * (depth / p.z);
+}
+
+void main()
+{
+  uvec3 cluster = gl_WorkGroupID;
+  uint clusterIndex = cluster.x + clusterSize.x *
+                      (cluster.y + clusterSize.y * cluster.z);
+
+  // AABB кластера в пространстве вида
+  if (gl_LocalInvocationIndex == 0) {
+    float zNear = clusterDepth.x, zFar = clusterDepth.y;
+    float slices = float(clusterSize.z);
+    float sliceNear = -zNear * pow(zFar / zNear, float(cluster.z) / slices);
+    float sliceFar = -zNear * pow(zFar / zNear, float(cluster.z + 1) / slices);
+    vec2 tileMin = vec2(cluster.xy) / vec2(clusterSize.xy) * 2.f - 1.f;
+    vec2 tileMax = vec2(cluster.xy + 1) / vec2(clusterSize.xy) * 2.f - 1.f;
+
+    vec3 corners[8] = vec3[8](
+      pointAtDepth(tileMin, sliceNear), pointAtDepth(tileMax, sliceNear),
+      pointAtDepth(vec2(tileMin.x, tileMax.y), sliceNear),
+      pointAtDepth(vec2(tileMax.x, tileMin.y), sliceNear),
+      pointAtDepth(tileMin, sliceFar), pointAtDepth(tileMax, sliceFar),
+      pointAtDepth(vec2(tileMin.x, tileMax.y), sliceFar),
+      pointAtDepth(vec2(tileMax.x, tileMin.y), sliceFar));
+    vec3 lo = corners[0], hi = corners[0];
+    for (int i = 1; i < 8; i++) {
+      lo = min(lo, corners[i]);
+      hi = max(hi, corners[i]);
+    }
+    aabbMin = lo;
+    aabbMax = hi;
+    lightCount = 0;
+  }
+  barrier();
+
+  // Проверка сфер источников на пересечение с AABB
+  uint base = clusterIndex * clusterSize.w;
+  for (uint i = gl_LocalInvocationIndex; i < pointLightCount;
+       i += gl_WorkGroupSize.x) {
+    float range = pointLights[i].range;
+    if (range <= 0.f)
+      continue;
+    vec3 center = (view * vec4(pointLights[i].position, 1.f)).xyz;
+    vec3 closest = clamp(center, aabbMin, aabbMax);
+    vec3 delta = center - closest;
+    if (dot(delta, delta) <= range * range) {
+      uint slot = atomicAdd(lightCount, 1u);
+      if (slot < clusterSize.w)
+        clusterLightIndices[base + slot] = i;
+    }
+  }
+  barrier();
+
+  if (gl_LocalInvocationIndex == 0)
+    clusterLightCounts[clusterIndex] = min(lightCount, clusterSize.w);
+}
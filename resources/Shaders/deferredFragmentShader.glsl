@@ -0,0 +1,212 @@
+#version 460 core
+// Проход освещения отложенного освещения (GBuffer.h): освещение считается
+// один раз на пиксель по данным G-буфера; точечные источники берутся из
+// кластера пикселя, как в lightFragmentShader.glsl
+// Варианты (ShaderVariants.h): HAS_DIR_LIGHT, HAS_POINT_LIGHTS,
+// HAS_SPOT_LIGHT, CLUSTERED_LIGHTING
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// G-буфер
+layout (binding = 0) uniform sampler2D gAlbedoSpecular;
+layout (binding = 1) uniform sampler2D gNormal;
+layout (binding = 2) uniform sampler2D gDepth;
+
+// Восстановление мировой позиции по глубине
+uniform mat4 inverseViewProj;
+
+// Данные кадра (FrameUniforms.h)
+layout (std140, binding = 0) uniform FrameData {
+  mat4 view;
+  mat4 projection;
+  mat4 viewProj;
+  vec4 cameraPos;
+  vec4 time;
+};
+
+// Источники света (LightManager.h, std430)
+struct DirLight {
+  vec3 direction;
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+};
+
+struct PointLight {
+  vec3 position;
+  float linear;
+  vec3 ambient;
+  float quadratic;
+  vec3 diffuse;
+  float range;
+  vec3 specular;
+};
+
+struct SpotLight {
+  vec3 position;
+  float cutOff;
+  vec3 direction;
+  float outerCutOff;
+  vec3 ambient;
+  float linear;
+  vec3 diffuse;
+  float quadratic;
+  vec3 specular;
+};
+
+layout (std430, binding = 2) readonly buffer PointLightBuffer {
+  uint pointLightCount;
+  PointLight pointLights[];
+};
+layout (std430, binding = 3) readonly buffer SpotLightBuffer {
+  uint spotLightCount;
+  SpotLight spotLights[];
+};
+layout (std430, binding = 4) readonly buffer DirLightBuffer {
+  uint dirLightCount;
+  DirLight dirLights[];
+};
+
+// Кластеры точечных источников (ClusteredLighting.h)
+layout (std430, binding = 5) readonly buffer ClusterGrid {
+  uvec4 clusterSize;
+  vec4 clusterDepth;
+  vec4 clusterScreen;
+  mat4 inverseProjection;
+  uint clusterLightCounts[];
+};
+layout (std430, binding = 6) readonly buffer ClusterIndices {
+  uint clusterLightIndices[];
+};
+
+// Параметры поверхности из G-буфера
+struct Surface {
+  vec3 position;
+  vec3 normal;
+  vec3 albedo;
+  float specular;
+  float shininess;
+};
+
+vec3 octDecode(vec2 e)
+{
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
+
+// Декларация функций
+// ------------------
+vec3 CalcDirLight(DirLight light, Surface s, vec3 viewDir);
+vec3 CalcPointLight(PointLight light, Surface s, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, Surface s, vec3 viewDir);
+
+void main()
+{
+  float depth = texture(gDepth, TexCoords).r;
+  // Пиксель без геометрии
+  if (depth == 1.0)
+    discard;
+  gl_FragDepth = depth;
+
+  vec4 albedoSpecular = texture(gAlbedoSpecular, TexCoords);
+  vec4 normalShininess = texture(gNormal, TexCoords);
+  vec3 ndc = vec3(TexCoords, depth) * 2.0 - 1.0;
+  vec4 position = inverseViewProj * vec4(ndc, 1.0);
+
+  Surface s;
+  s.position = position.xyz / position.w;
+  s.normal = octDecode(normalShininess.xy * 2.0 - 1.0);
+  s.albedo = albedoSpecular.rgb;
+  s.specular = albedoSpecular.a;
+  s.shininess = exp2(normalShininess.z * 10.0);
+  vec3 viewDir = normalize(cameraPos.xyz - s.position);
+
+  vec3 result = vec3(0.0);
+
+#ifdef HAS_DIR_LIGHT
+  // Направленный свет
+  for (uint i = 0; i < dirLightCount; i++)
+    result += CalcDirLight(dirLights[i], s, viewDir);
+#endif
+
+#ifdef HAS_POINT_LIGHTS
+  // Точечный свет
+#ifdef CLUSTERED_LIGHTING
+  float viewDepth = -(view * vec4(s.position, 1.0)).z;
+  uvec3 cluster = uvec3(
+    uvec2(gl_FragCoord.xy / clusterScreen.xy * vec2(clusterSize.xy)),
+    uint(max(log(viewDepth) * clusterDepth.z + clusterDepth.w, 0.0)));
+  cluster = min(cluster, clusterSize.xyz - 1u);
+  uint clusterIndex = cluster.x + clusterSize.x *
+                      (cluster.y + clusterSize.y * cluster.z);
+  uint base = clusterIndex * clusterSize.w;
+  uint count = clusterLightCounts[clusterIndex];
+  for (uint i = 0; i < count; i++)
+    result += CalcPointLight(pointLights[clusterLightIndices[base + i]], s,
+                             viewDir);
+#else
+  for (uint i = 0; i < pointLightCount; i++)
+    result += CalcPointLight(pointLights[i], s, viewDir);
+#endif
+#endif
+
+#ifdef HAS_SPOT_LIGHT
+  // "Прожекторный" свет
+  for (uint i = 0; i < spotLightCount; i++)
+    result += CalcSpotLight(spotLights[i], s, viewDir);
+#endif
+
+  FragColor = vec4(result, 1.0);
+}
+
+// Реализация функций
+// ------------------
+// Функция подсчета направленного света
+vec3 CalcDirLight(DirLight light, Surface s, vec3 viewDir) {
+  vec3 lightDir = normalize(-light.direction);
+  float diff = max(dot(s.normal, lightDir), 0.0);
+  vec3 reflectDir = reflect(-lightDir, s.normal);
+  float spec = pow(max(dot(viewDir, reflectDir), 0.0), s.shininess);
+
+  return light.ambient * s.albedo + light.diffuse * diff * s.albedo +
+         light.specular * spec * s.specular;
+}
+
+// Функция подсчета точечного света
+vec3 CalcPointLight(PointLight light, Surface s, vec3 viewDir) {
+  float dist = length(light.position - s.position);
+  float attenuation = 1.0 / (1.0 + light.linear * dist +
+                             light.quadratic * dist * dist);
+
+  vec3 lightDir = normalize(light.position - s.position);
+  float diff = max(dot(s.normal, lightDir), 0.0);
+  vec3 reflectDir = reflect(-lightDir, s.normal);
+  float spec = pow(max(dot(viewDir, reflectDir), 0.0), s.shininess);
+
+  return (light.ambient * s.albedo + light.diffuse * diff * s.albedo +
+          light.specular * spec * s.specular) * attenuation;
+}
+
+// Функция подсчета прожекторного света
+vec3 CalcSpotLight(SpotLight light, Surface s, vec3 viewDir) {
+  vec3 lightDir = normalize(light.position - s.position);
+  float theta = dot(lightDir, normalize(-light.direction));
+  float epsilon = light.cutOff - light.outerCutOff;
+  float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+  float dist = length(light.position - s.position);
+  float attenuation = 1.0 / (1.0 + light.linear * dist +
+                             light.quadratic * dist * dist);
+
+  vec3 reflectDir = reflect(-lightDir, s.normal);
+  vec3 result = light.diffuse * max(dot(s.normal, lightDir), 0.0) * s.albedo +
+                light.ambient * s.albedo +
+                light.specular *
+                    pow(max(dot(viewDir, reflectDir), 0.0), s.shininess) *
+                    s.specular;
+
+  return result * attenuation * intensity;
+}
@@ -0,0 +1,10 @@
+#version 460 core
+// Треугольник на весь экран без вершинных атрибутов (GBuffer.h)
+out vec2 TexCoords;
+
+void main()
+{
+  vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  TexCoords = position;
+  gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 460 core
+// Пишется только глубина
+
+void main()
+{
+}
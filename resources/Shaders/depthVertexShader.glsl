@@ -0,0 +1,65 @@
+#version 460 core
+// Проходы глубины: читается только поток позиций (VertexPosition)
+layout (location = 0) in vec4 aPos;
+
+// Деквантование позиции: posOffset + aPos.xyz * posScale
+uniform vec3 posOffset;
+uniform vec3 posScale;
+
+uniform mat4 model;
+
+// Данные кадра (FrameUniforms.h)
+layout (std140, binding = 0) uniform FrameData {
+  mat4 view;
+  mat4 projection;
+  mat4 viewProj;
+  vec4 cameraPos;
+  vec4 time;
+};
+
+// Непрямая отрисовка и экземпляры (см. lightVertexShader.glsl)
+struct DrawData {
+  vec3 posOffset;
+  uint transform;
+  vec3 posScale;
+  uint padding;
+};
+layout (std430, binding = 0) readonly buffer DrawBuffer {
+  DrawData draws[];
+};
+
+struct Transform {
+  mat4 model;
+  mat4 normalMatrix;
+};
+layout (std430, binding = 1) readonly buffer TransformBuffer {
+  Transform transforms[];
+};
+
+uniform bool indirectDraw;
+uniform bool instancedDraw;
+uniform uint drawBase;
+
+// Предварительный проход глубины сравнивается с проходом цвета по
+// GL_EQUAL: позиция вычисляется тем же выражением, что и в
+// lightVertexShader.glsl, и объявлена invariant
+invariant gl_Position;
+
+void main()
+{
+  vec3 offset = posOffset;
+  vec3 scale = posScale;
+  mat4 modelMatrix = model;
+  if (indirectDraw) {
+    DrawData draw = draws[drawBase + gl_DrawID];
+    offset = draw.posOffset;
+    scale = draw.posScale;
+    modelMatrix = transforms[draw.transform + uint(gl_InstanceID)].model;
+  } else if (instancedDraw) {
+    modelMatrix = transforms[gl_InstanceID].model;
+  }
+
+  vec3 position = offset + aPos.xyz * scale;
+  vec4 worldPos = modelMatrix * vec4(position, 1.0);
+  gl_Position = viewProj * worldPos;
+}
@@ -0,0 +1,61 @@
+#version 460 core
+// Проход геометрии отложенного освещения (GBuffer.h)
+// Варианты (ShaderVariants.h): HAS_SPECULAR_MAP, HAS_NORMAL_MAP
+layout (location = 0) out vec4 gAlbedoSpecular;
+layout (location = 1) out vec4 gNormal;
+
+// Материал (Material.h): текстуры на фиксированных блоках, параметры - в
+// SSBO по индексу из вершинного шейдера (gl_BaseInstance)
+layout (binding = 0) uniform sampler2D texture_diffuse;
+layout (binding = 1) uniform sampler2D texture_specular;
+layout (binding = 2) uniform sampler2D texture_normal;
+
+struct Material {
+  float shininess;
+};
+layout (std430, binding = 7) readonly buffer MaterialBuffer {
+  Material materials[];
+};
+flat in uint MaterialIndex;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+#ifdef HAS_NORMAL_MAP
+in mat3 TBN;
+#endif
+
+// Октаэдрическое кодирование нормали в [0, 1]^2
+vec2 octEncode(vec3 n)
+{
+  n /= abs(n.x) + abs(n.y) + abs(n.z);
+  vec2 e = n.xy;
+  if (n.z < 0.0)
+    e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0,
+                                 n.y >= 0.0 ? 1.0 : -1.0);
+  return e * 0.5 + 0.5;
+}
+
+void main()
+{
+  Material material = materials[MaterialIndex];
+#ifdef HAS_SPECULAR_MAP
+  float specular = texture(texture_specular, TexCoords).r;
+#else
+  float specular = 0.0;
+#endif
+#ifdef HAS_NORMAL_MAP
+  // Карта нормалей хранит только x и y (BC5), z восстанавливается
+  vec3 mapNormal;
+  mapNormal.xy = texture(texture_normal, TexCoords).rg * 2.0 - 1.0;
+  mapNormal.z = sqrt(max(0.0, 1.0 - dot(mapNormal.xy, mapNormal.xy)));
+  vec3 normal = normalize(TBN * mapNormal);
+#else
+  vec3 normal = normalize(Normal);
+#endif
+
+  gAlbedoSpecular = vec4(texture(texture_diffuse, TexCoords).rgb,
+                         specular);
+  gNormal = vec4(octEncode(normal),
+                 log2(max(material.shininess, 1.0)) / 10.0, 0.0);
+}
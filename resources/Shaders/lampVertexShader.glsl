@@ -1,11 +1,24 @@
 #version 460 core
-layout (location = 0) in vec3 aPos;
+// Позиция в пределах AABB меша (VertexPosition)
+layout (location = 0) in vec4 aPos;
+
+// Деквантование позиции: posOffset + aPos.xyz * posScale
+uniform vec3 posOffset;
+uniform vec3 posScale;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Данные кадра (FrameUniforms.h)
+layout (std140, binding = 0) uniform FrameData {
+  mat4 view;
+  mat4 projection;
+  mat4 viewProj;
+  vec4 cameraPos;
+  vec4 time;
+};
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 position = posOffset + aPos.xyz * posScale;
+    gl_Position = viewProj * (model * vec4(position, 1.0));
 }
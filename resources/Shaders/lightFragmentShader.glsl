@@ -1,61 +1,97 @@
 #version 460 core
+// Варианты (ShaderVariants.h): HAS_DIR_LIGHT, HAS_POINT_LIGHTS,
+// HAS_SPOT_LIGHT, CLUSTERED_LIGHTING, HAS_SPECULAR_MAP, HAS_NORMAL_MAP
 out vec4 FragColor;
 
-struct Material {
-  sampler2D texture_diffuse1;
-  sampler2D texture_diffuse2;
-  sampler2D texture_diffuse3;
-  sampler2D texture_specular1;
-  sampler2D texture_specular2;
+// Материал (Material.h): текстуры на фиксированных блоках, параметры - в
+// SSBO по индексу из вершинного шейдера (gl_BaseInstance)
+layout (binding = 0) uniform sampler2D texture_diffuse;
+layout (binding = 1) uniform sampler2D texture_specular;
+layout (binding = 2) uniform sampler2D texture_normal;
 
+struct Material {
   float shininess;
 };
-uniform Material material;
+layout (std430, binding = 7) readonly buffer MaterialBuffer {
+  Material materials[];
+};
+flat in uint MaterialIndex;
 
+// Источники света (LightManager.h, std430)
 struct DirLight {
   vec3 direction;
-
   vec3 ambient;
   vec3 diffuse;
   vec3 specular;
 };
-uniform DirLight dirLight;
 
 struct PointLight {
   vec3 position;
-
   float linear;
-  float quadratic;
-
   vec3 ambient;
+  float quadratic;
   vec3 diffuse;
+  float range; // Радиус действия (LIGHT_CUTOFF)
   vec3 specular;
 };
-#define MAX_POINT_LIGHTS 10
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform uint acutalPointLights;
 
 struct SpotLight {
   vec3 position;
-  vec3 direction;
-
   float cutOff;
+  vec3 direction;
   float outerCutOff;
-
-  float linear;
-  float quadratic;
-
   vec3 ambient;
+  float linear;
   vec3 diffuse;
+  float quadratic;
   vec3 specular;
 };
-uniform SpotLight spotLight;
+
+layout (std430, binding = 2) readonly buffer PointLightBuffer {
+  uint pointLightCount;
+  PointLight pointLights[];
+};
+layout (std430, binding = 3) readonly buffer SpotLightBuffer {
+  uint spotLightCount;
+  SpotLight spotLights[];
+};
+layout (std430, binding = 4) readonly buffer DirLightBuffer {
+  uint dirLightCount;
+  DirLight dirLights[];
+};
+
+// Кластеры точечных источников (ClusteredLighting.h)
+layout (std430, binding = 5) readonly buffer ClusterGrid {
+  uvec4 clusterSize;  // xyz - число кластеров, w - максимум источников
+  vec4 clusterDepth;  // x - near, y - far, z/w - масштаб и смещение среза
+  vec4 clusterScreen; // xy - размер экрана
+  mat4 inverseProjection;
+  uint clusterLightCounts[];
+};
+layout (std430, binding = 6) readonly buffer ClusterIndices {
+  uint clusterLightIndices[];
+};
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
-
-uniform vec3 viewPos;
+#ifdef HAS_NORMAL_MAP
+in mat3 TBN;
+#endif
+
+// Цвета материала фрагмента (читаются один раз, а не для каждого источника)
+vec3 diffuseColor;
+vec3 specularColor;
+Material material;
+
+// Данные кадра (FrameUniforms.h)
+layout (std140, binding = 0) uniform FrameData {
+  mat4 view;
+  mat4 projection;
+  mat4 viewProj;
+  vec4 cameraPos;
+  vec4 time;
+};
 
 // Декларация функций
 // ------------------
@@ -70,25 +106,56 @@ void main()
 {
   vec3 result = vec3(0.f);
 
+  material = materials[MaterialIndex];
+  diffuseColor = texture(texture_diffuse, TexCoords).rgb;
+#ifdef HAS_SPECULAR_MAP
+  specularColor = texture(texture_specular, TexCoords).rgb;
+#else
+  specularColor = vec3(0.f);
+#endif
+
+#ifdef HAS_NORMAL_MAP
+  // Карта нормалей хранит только x и y (BC5), z восстанавливается
+  vec3 mapNormal;
+  mapNormal.xy = texture(texture_normal, TexCoords).rg * 2.f - 1.f;
+  mapNormal.z = sqrt(max(0.f, 1.f - dot(mapNormal.xy, mapNormal.xy)));
+  vec3 norm = normalize(TBN * mapNormal);
+#else
   vec3 norm = normalize(Normal);
-  vec3 viewDir = normalize(viewPos - FragPos);
+#endif
+  vec3 viewDir = normalize(cameraPos.xyz - FragPos);
 
+#ifdef HAS_DIR_LIGHT
   // Направленный свет
-  if (dirLight.ambient != vec3(0.f) || dirLight.diffuse != vec3(0.f) || dirLight.specular != vec3(0.f)) {
-    result = CalcDirLight(dirLight, norm, viewDir);
-  }
+  for (uint i = 0; i < dirLightCount; i++)
+    result += CalcDirLight(dirLights[i], norm, viewDir);
+#endif
 
+#ifdef HAS_POINT_LIGHTS
   // Точечный свет
-  for (int i = 0; i < acutalPointLights && i < MAX_POINT_LIGHTS; i++) {
-    if (pointLights[i].ambient != vec3(0.f) || pointLights[i].diffuse != vec3(0.f) || pointLights[i].specular != vec3(0.f)) {
-      result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
-    }
-  }
-
+#ifdef CLUSTERED_LIGHTING
+  // Кластер: тайл экрана и экспоненциальный срез глубины
+  float viewDepth = -(view * vec4(FragPos, 1.f)).z;
+  uvec3 cluster = uvec3(
+    uvec2(gl_FragCoord.xy / clusterScreen.xy * vec2(clusterSize.xy)),
+    uint(max(log(viewDepth) * clusterDepth.z + clusterDepth.w, 0.f)));
+  cluster = min(cluster, clusterSize.xyz - 1u);
+  uint clusterIndex = cluster.x + clusterSize.x * (cluster.y + clusterSize.y * cluster.z);
+  uint base = clusterIndex * clusterSize.w;
+  uint count = clusterLightCounts[clusterIndex];
+  for (uint i = 0; i < count; i++)
+    result += CalcPointLight(pointLights[clusterLightIndices[base + i]], norm, FragPos, viewDir);
+#else
+  for (uint i = 0; i < pointLightCount; i++)
+    result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+#endif
+#endif
+
+#ifdef HAS_SPOT_LIGHT
   // "Прожекторный" свет
-  if (spotLight.ambient != vec3(0.f) || spotLight.diffuse != vec3(0.f) || spotLight.specular != vec3(0.f)) {
-    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
-  }
+  for (uint i = 0; i < spotLightCount; i++)
+    result += CalcSpotLight(spotLights[i], norm, FragPos, viewDir);
+#endif
 
   FragColor = vec4(result, 1.f);
 }
@@ -107,9 +174,9 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
   float spec = pow(max(dot(viewDir, reflectDir), 0.f), material.shininess);
 
   // Результат
-  vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords));
-  vec3 diffuse = light.diffuse * diff * vec3(texture(material.texture_diffuse1, TexCoords));
-  vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords));
+  vec3 ambient = light.ambient * diffuseColor;
+  vec3 diffuse = light.diffuse * diff * diffuseColor;
+  vec3 specular = light.specular * spec * specularColor;
 
   return (ambient + diffuse + specular);
 }
@@ -123,16 +190,16 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
   // diffuse
   vec3 lightDir = normalize(light.position - fragPos);
   float diff = max(dot(normal, lightDir), 0.f);
-  vec3 diffuse = light.diffuse * diff * texture(material.texture_diffuse1, TexCoords).rgb;
+  vec3 diffuse = light.diffuse * diff * diffuseColor;
 
   // specular
   vec3 reflectDir = reflect(-lightDir, normal);
   //float spec = pow(max(dot(viewDir, reflectDir), 0.f), material.shininess);
   float spec = pow(max(dot(viewDir, reflectDir), 0.f), material.shininess);
-  vec3 specular = light.specular * spec * texture(material.texture_specular1, TexCoords).rgb;
+  vec3 specular = light.specular * spec * specularColor;
 
   // ambient
-  vec3 ambient = light.ambient * texture(material.texture_diffuse1, TexCoords).rgb;
+  vec3 ambient = light.ambient * diffuseColor;
 
   return (ambient + diffuse + specular) * attenuation;
 }
@@ -150,14 +217,14 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
   float attenuation = 1.f / (1.f + light.linear * dist + light.quadratic * pow(dist, 2));
 
   // diffuse
-  result += light.diffuse * max(dot(normal, lightDir), 0.f) * texture(material.texture_diffuse1, TexCoords).rgb;
+  result += light.diffuse * max(dot(normal, lightDir), 0.f) * diffuseColor;
 
   // ambient
-  result += light.ambient * texture(material.texture_diffuse1, TexCoords).rgb;
+  result += light.ambient * diffuseColor;
 
   // specular
   vec3 reflectDir = reflect(-lightDir, normal);
-  result += light.specular * pow(max(dot(viewDir, reflectDir), 0.f), material.shininess) * texture(material.texture_specular1, TexCoords).rgb;
+  result += light.specular * pow(max(dot(viewDir, reflectDir), 0.f), material.shininess) * specularColor;
 
   result *= attenuation * intensity;
 
@@ -1,23 +1,111 @@
 #version 460 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+// Сжатая вершина (VertexFormats.h): позиция в пределах AABB меша,
+// октаэдрическая нормаль
+layout (location = 0) in vec4 aPos;
+layout (location = 1) in vec2 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#ifdef HAS_NORMAL_MAP
+// Октаэдрическая касательная; знак бикасательной - в aPos.w
+layout (location = 3) in vec2 aTangent;
+#endif
+
+// Деквантование позиции: posOffset + aPos.xyz * posScale
+uniform vec3 posOffset;
+uniform vec3 posScale;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Данные кадра (FrameUniforms.h)
+layout (std140, binding = 0) uniform FrameData {
+  mat4 view;
+  mat4 projection;
+  mat4 viewProj;
+  vec4 cameraPos;
+  vec4 time;
+};
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+// Индекс параметров материала (Material.h)
+flat out uint MaterialIndex;
+#ifdef HAS_NORMAL_MAP
+out mat3 TBN;
+#endif
 
 uniform mat3 normalMatrix;
 
+// Непрямая отрисовка (IndirectDraw.h): параметры меша и трансформация
+// берутся из SSBO по drawBase + gl_DrawID вместо uniform-переменных;
+// экземпляры (InstanceBuffer.h) берут трансформацию по gl_InstanceID
+struct DrawData {
+  vec3 posOffset;
+  uint transform;
+  vec3 posScale;
+  uint padding;
+};
+layout (std430, binding = 0) readonly buffer DrawBuffer {
+  DrawData draws[];
+};
+
+struct Transform {
+  mat4 model;
+  mat4 normalMatrix;
+};
+layout (std430, binding = 1) readonly buffer TransformBuffer {
+  Transform transforms[];
+};
+
+uniform bool indirectDraw;
+uniform bool instancedDraw;
+uniform uint drawBase;
+
+// Позиция совпадает с depthVertexShader.glsl бит в бит (предварительный
+// проход глубины и GL_EQUAL)
+invariant gl_Position;
+
+vec3 octDecode(vec2 e)
+{
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
+
 void main()
 {
-  FragPos = vec3(model * vec4(aPos, 1.0));
-  Normal = normalMatrix * aNormal;
+  vec3 offset = posOffset;
+  vec3 scale = posScale;
+  mat4 modelMatrix = model;
+  mat3 normalMat = normalMatrix;
+  if (indirectDraw) {
+    DrawData draw = draws[drawBase + gl_DrawID];
+    offset = draw.posOffset;
+    scale = draw.posScale;
+    uint transform = draw.transform + uint(gl_InstanceID);
+    modelMatrix = transforms[transform].model;
+    normalMat = mat3(transforms[transform].normalMatrix);
+  } else if (instancedDraw) {
+    modelMatrix = transforms[gl_InstanceID].model;
+    normalMat = mat3(transforms[gl_InstanceID].normalMatrix);
+  }
+
+  vec3 position = offset + aPos.xyz * scale;
+  // Сначала мировая позиция (mat4 x vec4), затем проекция: без скобок
+  // вычислялось бы произведение матриц на каждую вершину
+  vec4 worldPos = modelMatrix * vec4(position, 1.0);
+  FragPos = worldPos.xyz;
+  Normal = normalMat * octDecode(aNormal);
   TexCoords = aTexCoords;
+  MaterialIndex = uint(gl_BaseInstance);
+#ifdef HAS_NORMAL_MAP
+  // Касательная ортогонализуется к нормали (Грам-Шмидт)
+  vec3 N = normalize(Normal);
+  vec3 T = normalize(mat3(modelMatrix) * octDecode(aTangent));
+  T = normalize(T - dot(T, N) * N);
+  vec3 B = cross(N, T) * (aPos.w * 2.0 - 1.0);
+  TBN = mat3(T, B, N);
+#endif
 
-  gl_Position = projection * view * model * vec4(aPos, 1.0);
+  gl_Position = viewProj * worldPos;
 }
@@ -8,12 +8,36 @@
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 // Остальные библиотеки
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
 // Остальные заголовочные файлы
+#include "LearnOpenGL/AssetRegistry.h" // Реестр ассетов
 #include "LearnOpenGL/Camera.h" // Класс камеры
+#include "LearnOpenGL/ClusteredLighting.h" // Кластерное освещение
+#include "LearnOpenGL/FrameUniforms.h" // Данные кадра
+#include "LearnOpenGL/GBuffer.h"       // G-буфер
+#include "LearnOpenGL/GLState.h"       // Кеш состояния OpenGL
+#include "LearnOpenGL/GpuCounter.h"    // Счетчик GPU
+#include "LearnOpenGL/GeometryHeap.h" // Куча геометрии
+#include "LearnOpenGL/GpuTimer.h" // Таймер GPU
+#include "LearnOpenGL/IndirectDraw.h" // Непрямая отрисовка
+#include "LearnOpenGL/InstanceBuffer.h" // Буфер экземпляров
+#include "LearnOpenGL/LightManager.h"   // Менеджер источников света
+#include "LearnOpenGL/Material.h"       // Таблица материалов
+#include "LearnOpenGL/Mesh.h"   // Класс меша
 #include "LearnOpenGL/Model.h"  // Класс модели
+#include "LearnOpenGL/RenderQueue.h" // Очередь отрисовки
 #include "LearnOpenGL/Shader.h" // Класс шейдера
+#include "LearnOpenGL/ShaderCompiler.h" // Параллельная компиляция
+#include "LearnOpenGL/ShaderVariants.h" // Варианты шейдеров
+#include "LearnOpenGL/TextureStreamer.h" // Асинхронная загрузка текстур
+#include "LearnOpenGL/VertexPacking.h"   // Упаковка вершин
 
 // Прототипы функций колбэков
 // --------------------------
@@ -89,6 +113,8 @@ struct PointLight {
   float diff = 0.3f;
   float amb = 1.f;
   float spec = 0.1f;
+
+  std::uint32_t light = 0; // Идентификатор в LightManager
 };
 
 // Точка входа в программу
@@ -151,6 +177,10 @@ int main() {
     std::cout << "Failed to initialize OpenGL context\n" << std::endl;
     return -1;
   }
+  // Параллельная компиляция шейдеров драйвером (если поддерживается)
+  ShaderCompiler::instance().init(glfwGetProcAddress);
+  // Кеш состояния OpenGL: привязки и флаги меняются только через него
+  GLState &glState = GLState::instance();
 
   // Определение области отрисовки
   // -----------------------------
@@ -159,14 +189,30 @@ int main() {
 
   // Шейдеры
   // -------
-  // Шейдер для отрисовки куба
-  Shader objShader("./resources/Shaders/lightVertexShader.glsl",
-                   "./resources/Shaders/lightFragmentShader.glsl");
+  // Варианты шейдера освещения: набор источников сцены и карт материала
+  ShaderVariants objShaders("./resources/Shaders/lightVertexShader.glsl",
+                            "./resources/Shaders/lightFragmentShader.glsl",
+                            SHADER_SCENE_FEATURES | SHADER_MATERIAL_FEATURES);
 
   // Шейдер для отрисовки источника света
   Shader lampShader("./resources/Shaders/lampVertexShader.glsl",
                     "./resources/Shaders/lampFragmentShader.glsl");
 
+  // Шейдер прохода глубины (только позиции)
+  Shader depthShader("./resources/Shaders/depthVertexShader.glsl",
+                     "./resources/Shaders/depthFragmentShader.glsl");
+
+  // Шейдеры отложенного освещения: запись G-буфера (карты материала) и
+  // проход освещения (источники сцены)
+  ShaderVariants gbufferShaders(
+      "./resources/Shaders/lightVertexShader.glsl",
+      "./resources/Shaders/gbufferFragmentShader.glsl",
+      SHADER_MATERIAL_FEATURES);
+  ShaderVariants deferredShaders(
+      "./resources/Shaders/deferredVertexShader.glsl",
+      "./resources/Shaders/deferredFragmentShader.glsl",
+      SHADER_SCENE_FEATURES);
+
   // Вершины
   // -------
   // Координаты вершин
@@ -234,28 +280,79 @@ int main() {
 
   // Рюкзак
   // ------
-  Model ourModel((char *)"./resources/Objects/backpack/backpack.obj");
+  const char *backpackPath = "./resources/Objects/backpack/backpack.obj";
+  Model ourModel(backpackPath);
+  // Варианты без источников света компилируются заранее и служат
+  // запасными, пока собираются варианты для текущей сцены
+  for (std::uint32_t material : ourModel.materials()) {
+    objShaders.prefetch(material);
+    gbufferShaders.prefetch(material);
+  }
+  deferredShaders.prefetch(0);
 
-  // Буфер вершин для куба
+  // Замер прохода глубины
   // ---------------------
-  unsigned int cubeVBO;
-  glCreateBuffers(1, &cubeVBO);
-  // Заполняем буфер вершин
-  glNamedBufferStorage(cubeVBO, sizeof(vertices), vertices, 0);
-
-  // Буфер массива вершин для источника света
-  // ---------------------------------
-  // Создаем VAO
-  unsigned int lampVAO;
-  glCreateVertexArrays(1, &lampVAO);
-
-  // Включаем и устанавливаем атрибуты вершин
-  // Позиция вершин
-  glVertexArrayAttribFormat(lampVAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
-  glVertexArrayAttribBinding(lampVAO, 0, 0);
-  glEnableVertexArrayAttrib(lampVAO, 0);
-  // Связываем атрибуты с текущим VBO
-  glVertexArrayVertexBuffer(lampVAO, 0, cubeVBO, 0, 8 * sizeof(float));
+  // Рюкзак с отдельным потоком позиций загружается при первом включении
+  // замера; оба варианта рисуются только в буфер глубины, и время прохода
+  // сравнивается в окне ImGui
+  bool depthBenchmark = false;
+  int depthBenchmarkRepeats = 8;
+  std::optional<Model> splitModel;
+  GpuTimer interleavedTimer, splitTimer;
+
+  // Способ отрисовки рюкзаков
+  // -------------------------
+  // Per mesh - вызов на меш и экземпляр, Indirect - вся сцена одним списком
+  // glMultiDrawElementsIndirect, Instanced - вызов на меш для всех
+  // экземпляров (трансформации в InstanceBuffer), Sorted queue - вызов на
+  // видимый меш и экземпляр в порядке ключа очереди отрисовки (по
+  // состоянию и от ближних к дальним; запись - на рабочих потоках)
+  enum DrawMode : int {
+    DRAW_PER_MESH,
+    DRAW_INDIRECT,
+    DRAW_INSTANCED,
+    DRAW_QUEUE
+  };
+  const char *drawModeNames[] = {"Per mesh", "Indirect", "Instanced",
+                                 "Sorted queue"};
+  int drawMode = DRAW_INSTANCED;
+  int backpackCount = 10; // Число экземпляров
+  IndirectDrawList sceneDraws;
+  RenderQueue renderQueue;
+  std::size_t queueStateChanges = 0;
+  InstanceBuffer backpackInstances;
+  // Отложенное освещение: рюкзаки пишутся в G-буфер, а освещение
+  // считается одним проходом на пиксель
+  bool deferredShading = false;
+  GBuffer gbuffer;
+  // Предварительный проход глубины и число фрагментов, закрашенных
+  // проходом цвета рюкзаков (отношение к числу пикселей - перерисовка)
+  bool depthPrepass = false;
+  GpuCounter shadedFragments(GL_FRAGMENT_SHADER_INVOCATIONS);
+
+  // Меш источника света
+  // --------------------
+  // Источнику света нужны только позиции (формат VertexPosition, 8 байт);
+  // совпадающие позиции вершин куба объединяются
+  std::vector<Vertex> cubeVertices;
+  std::vector<unsigned int> cubeIndices;
+  for (std::size_t i = 0; i < std::size(vertices); i += 8) {
+    Vertex vertex = {};
+    vertex.Position = glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]);
+    auto same = std::find_if(cubeVertices.begin(), cubeVertices.end(),
+                             [&vertex](const Vertex &other) {
+                               return other.Position == vertex.Position;
+                             });
+    cubeIndices.push_back(
+        static_cast<unsigned int>(same - cubeVertices.begin()));
+    if (same == cubeVertices.end())
+      cubeVertices.push_back(vertex);
+  }
+  std::vector<VertexPosition> lampVertices(cubeVertices.size());
+  VertexQuantization lampQuantization =
+      VertexPacking::pack<VertexPosition>(cubeVertices, lampVertices);
+  Mesh<VertexPosition> lampMesh(lampVertices, cubeIndices, {}, 0.f,
+                                lampQuantization);
 
   // Настройка imgui
   // ---------------
@@ -281,6 +378,10 @@ int main() {
   glm::mat4 view = glm::mat4(1.0f);
   // Матрица проекции
   glm::mat4 projection = glm::mat4(1.0f);
+  const float zNear = 0.1f, zFar = 1000.0f; // Плоскости отсечения
+  // Буфер данных кадра (вид, проекция, позиция камеры, время)
+  FrameUniforms frameUniforms;
+  frameUniforms.init();
 
   // Подготовка к рендерингу
   // -----------------------
@@ -288,12 +389,11 @@ int main() {
   glm::vec4 clearColor = glm::vec4(29.f / 255, 32.f / 255, 33.f / 255, 1.f);
   glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
   // Включение теста глубины
-  glEnable(GL_DEPTH_TEST);
+  glState.enable(GL_DEPTH_TEST);
 
-  /* Передача данных в шейдеры */
-  // Шейдер объекта
-  // Привязка шейдера
-  objShader.use();
+  /* Источники света */
+  // Хранятся в LightManager и загружаются в SSBO только при изменении
+  LightManager lights;
   // Точечный свет
   PointLight lamp[4] = {};
   lamp[0].position = glm::vec3(0.7f, 0.2f, 2.0f);
@@ -302,7 +402,8 @@ int main() {
   lamp[2].position = glm::vec3(-4.0f, 2.0f, -12.0f);
   lamp[3].position = glm::vec3(0.0f, 0.0f, -3.0f);
   unsigned int nrLamps = sizeof(lamp) / sizeof(lamp[0]);
-  objShader.setUInt("acutalPointLights", nrLamps);
+  for (unsigned int i = 0; i < nrLamps; i++)
+    lamp[i].light = lights.points.add({});
 
   // Направленный свет
   glm::vec3 dirColor = glm::vec3(0.0f);
@@ -322,6 +423,60 @@ int main() {
   float spotOuterAngle = glm::radians(19.f);
   float spotOuterCutOff = cos(spotOuterAngle);
 
+  // Идентификаторы направленного света и фонарика в LightManager
+  std::uint32_t dirLight = lights.directional.add({});
+  std::uint32_t spotLight = lights.spots.add({});
+
+  // Кластерное освещение
+  // --------------------
+  // Дополнительные точечные источники со случайными позициями и цветами
+  // нагружают освещение; время прохода рюкзаков с кластерами и без них
+  // сравнивается в окне ImGui
+  ClusteredLighting clusters("./resources/Shaders/clusterComputeShader.glsl");
+  bool clusteredLighting = true;
+  int extraLightCount = 0;
+  std::vector<std::uint32_t> extraLights;
+  std::mt19937 lightRandom(42);
+  auto randomLight = [&]() {
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    glm::vec3 position(-50.f + 100.f * unit(lightRandom),
+                       -10.f + 20.f * unit(lightRandom),
+                       -100.f + 110.f * unit(lightRandom));
+    glm::vec3 color(unit(lightRandom), unit(lightRandom), unit(lightRandom));
+    return PointLightDesc{position,         1.4f,          7.2f,
+                          glm::vec3(0.f),   color * 0.5f,  color * 0.5f};
+  };
+  GpuTimer clusterTimer, sceneTimer;
+
+  // Рюкзаки
+  glm::vec3 modelPositions[] = {
+      glm::vec3(0.0f, 0.0f, 0.0f),    glm::vec3(2.0f, 5.0f, -15.0f),
+      glm::vec3(-1.5f, -2.2f, -2.5f), glm::vec3(-3.8f, -2.0f, -12.3f),
+      glm::vec3(2.4f, -0.4f, -3.5f),  glm::vec3(-1.7f, 3.0f, -7.5f),
+      glm::vec3(1.3f, -2.0f, -2.5f),  glm::vec3(1.5f, 2.0f, -2.5f),
+      glm::vec3(1.5f, 0.2f, -1.5f),   glm::vec3(-1.3f, 1.0f, -1.5f),
+  };
+  // Матрица модели i-го рюкзака (рюкзаки сверх modelPositions
+  // располагаются сеткой 64x64 слоями за сценой)
+  auto backpackMatrix = [&](unsigned long i) {
+    glm::vec3 position;
+    if (i < std::size(modelPositions)) {
+      position = modelPositions[i];
+    } else {
+      unsigned long k = i - std::size(modelPositions);
+      position = glm::vec3((float)(k % 64) * 2.f - 64.f,
+                           (float)(k / 64 % 64) * 2.f - 64.f,
+                           -20.f - (float)(k / 4096) * 2.f);
+    }
+    glm::mat4 matrix = glm::mat4(1.0f);
+    matrix = glm::translate(matrix, position);
+    matrix = glm::rotate(matrix,
+                         glm::radians(20.f * (float)(i + 1) * (float)gameTime *
+                                      (float)(pow(-1, i))),
+                         glm::vec3(1.f, 0.3f, 0.5f));
+    return glm::scale(matrix, glm::vec3(0.3f));
+  };
+
   // Цикл рендеринга
   // ---------------
   while (!glfwWindowShouldClose(window)) {
@@ -333,6 +488,17 @@ int main() {
     realTime = glfwGetTime(); // Запоминаем реальное время
     deltaTime = gameTime - lastFrame; // Вычисляем время между кадрами
 
+    // Размер буфера кадра (может отличаться от размера окна и меняется при
+    // смене режима окна; у свернутого окна он нулевой)
+    int framebufferWidth = 0, framebufferHeight = 0;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    framebufferWidth = std::max(framebufferWidth, 1);
+    framebufferHeight = std::max(framebufferHeight, 1);
+
+    // Загрузка готовых текстур
+    // ------------------------
+    TextureStreamer::instance().update();
+
     // Новый кадр ImGui
     // ----------------
     if (!inputFlag) {
@@ -351,7 +517,11 @@ int main() {
     // Матрица проекции
     projection =
         glm::perspective(glm::radians(camera.Zoom),
-                         (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+                         (float)SCR_WIDTH / (float)SCR_HEIGHT, zNear, zFar);
+    // Загрузка данных кадра (общие для всех шейдеров)
+    frameUniforms.update({view, projection, projection * view,
+                          glm::vec4(camera.Position, 1.0f),
+                          glm::vec4((float)gameTime, (float)deltaTime, 0, 0)});
 
     // Обработка логики
     // ----------------
@@ -360,7 +530,6 @@ int main() {
     for (unsigned int i = 0; i < nrLamps; i++) {
       if (lamp[i].moveFlag) {
         lamp[i].position = camera.Position + glm::vec3(1.f) * camera.Front;
-        objShader.setVec3("pointLights[0].position", lamp[i].position);
       }
     }
 
@@ -369,17 +538,222 @@ int main() {
     // Очистка буфера цвета и буфера глубины
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    // Замер прохода глубины
+    // ---------------------
+    // Оба варианта рюкзака рисуются depthBenchmarkRepeats раз только в буфер
+    // глубины; после замера буфер глубины очищается
+    if (depthBenchmark) {
+      if (!splitModel)
+        splitModel.emplace(backpackPath, false,
+                           MODEL_DEFAULT_OPTIONS | MODEL_SPLIT_POSITIONS);
+      depthShader.use();
+      glState.colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      auto depthPass = [&](Model &backpack, GpuTimer &timer) {
+        timer.begin();
+        for (int repeat = 0; repeat < depthBenchmarkRepeats; repeat++)
+          for (unsigned long i = 0; i < std::size(modelPositions); i++) {
+            depthShader.drawUniforms().model.set(backpackMatrix(i));
+            backpack.DrawDepth(depthShader);
+          }
+        timer.end();
+        glClear(GL_DEPTH_BUFFER_BIT);
+      };
+      depthPass(ourModel, interleavedTimer);
+      depthPass(*splitModel, splitTimer);
+      glState.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    // Рюкзак
+    // ------
+    /* Применение настроек источников света */
+    // Направленный свет
+    lights.directional.set(dirLight, {glm::vec3(-0.2f, -1.0f, -0.3f),
+                                      dirAmbient, dirDiffuse, dirSpecular});
+
+    // Точечный свет
+    for (unsigned int i = 0; i < nrLamps; i++) {
+      glm::vec3 diffuse = lamp[i].color * lamp[i].diff;
+      lights.points.set(lamp[i].light,
+                        {lamp[i].position, lamp[i].linear, lamp[i].quadratic,
+                         diffuse * lamp[i].amb, diffuse,
+                         lamp[i].color * lamp[i].spec});
+    }
+
+    // Фонарик
+    lights.spots.set(spotLight,
+                     {camera.Position, camera.Front, spotCutOff,
+                      spotOuterCutOff, spotLinear, spotQuadratic, spotAmbient,
+                      spotDiffuse, spotSpecular});
+
+    // Дополнительные точечные источники
+    while (extraLights.size() < std::size_t(extraLightCount))
+      extraLights.push_back(lights.points.add(randomLight()));
+    while (extraLights.size() > std::size_t(extraLightCount)) {
+      lights.points.remove(extraLights.back());
+      extraLights.pop_back();
+    }
+
+    // Загрузка изменений в SSBO
+    lights.upload();
+    MaterialTable::instance().bind();
+
+    // Распределение точечных источников по кластерам
+    if (clusteredLighting) {
+      clusterTimer.begin();
+      clusters.update(projection, zNear, zFar,
+                      glm::vec2((float)framebufferWidth,
+                                (float)framebufferHeight));
+      clusterTimer.end();
+    }
+
+    // Возможности сцены для выбора вариантов шейдеров: циклы по
+    // отсутствующим источникам не компилируются
+    std::uint32_t sceneFeatures = 0;
+    if (dirColor != glm::vec3(0.f))
+      sceneFeatures |= SHADER_DIR_LIGHT;
+    if (lights.points.size())
+      sceneFeatures |= SHADER_POINT_LIGHTS;
+    if (spotColor != glm::vec3(0.f))
+      sceneFeatures |= SHADER_SPOT_LIGHT;
+    if (clusteredLighting)
+      sceneFeatures |= SHADER_CLUSTERED;
+
+    // Подготовка трансформаций рюкзаков
+    auto backpacks = static_cast<unsigned long>(backpackCount);
+    if (drawMode == DRAW_INSTANCED) {
+      // Матрицы экземпляров считаются участками на рабочих потоках
+      backpackInstances.update(backpacks, backpackMatrix);
+    } else if (drawMode == DRAW_INDIRECT) {
+      // Сбор списка всей сцены: экземпляры модели - одна команда на меш с
+      // трансформациями подряд (после clear() они нумеруются с 0)
+      sceneDraws.clear();
+      for (unsigned long i = 0; i < backpacks; i++)
+        sceneDraws.addTransform(backpackMatrix(i));
+      ourModel.Submit(sceneDraws, 0, static_cast<std::uint32_t>(backpacks));
+    }
+
+    // Отрисовка рюкзаков выбранным способом (depthOnly - только позиции,
+    // material - только меши с этим набором карт)
+    auto drawBackpacks = [&](Shader &shader, bool depthOnly,
+                             std::uint32_t material = ANY_MATERIAL) {
+      if (drawMode == DRAW_INSTANCED) {
+        if (depthOnly)
+          ourModel.DrawDepthInstanced(shader, backpackInstances);
+        else
+          ourModel.DrawInstanced(shader, backpackInstances, material);
+      } else if (drawMode == DRAW_INDIRECT) {
+        if (depthOnly)
+          sceneDraws.drawDepth(shader);
+        else
+          sceneDraws.draw(shader, material);
+      } else {
+        for (unsigned long i = 0; i < backpacks; i++) {
+          // Матрица модели
+          model = backpackMatrix(i);
+          shader.drawUniforms().model.set(model);
+          if (depthOnly) {
+            ourModel.DrawDepth(shader);
+            continue;
+          }
+
+          // Применение матрицы нормали
+          shader.drawUniforms().normalMatrix.set(
+              glm::transpose(glm::inverse(model)));
+
+          // Отрисовка объектов
+          ourModel.Draw(shader, material);
+        }
+      }
+    };
+
+    // Отложенное освещение: проход геометрии в G-буфер
+    ShaderVariants &backpackShaders =
+        deferredShading ? gbufferShaders : objShaders;
+
+    // Запись и сортировка очереди на рабочих потоках: проход глубины одним
+    // шейдером, проход цвета - вариантом для материала меша (варианты
+    // выбираются заранее на потоке контекста, один раз на набор карт)
+    if (drawMode == DRAW_QUEUE) {
+      std::vector<std::pair<std::uint32_t, Shader *>> variants;
+      for (std::uint32_t material : ourModel.materials())
+        variants.emplace_back(material,
+                              &backpackShaders.get(sceneFeatures | material));
+      auto variantFor = [&](std::uint32_t material) -> Shader & {
+        for (auto &[features, shader] : variants)
+          if (features == material)
+            return *shader;
+        return *variants.front().second;
+      };
+      auto depthFor = [&](std::uint32_t) -> Shader & { return depthShader; };
+
+      RenderView renderView(projection * view, camera.Position, camera.Front,
+                            zFar);
+      renderQueue.record(
+          renderView, backpacks,
+          [&](CommandBuffer &commands, std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; i++) {
+              std::uint32_t transform =
+                  commands.addTransform(backpackMatrix(i));
+              if (depthPrepass)
+                ourModel.Enqueue(commands, PASS_DEPTH, transform, depthFor);
+              ourModel.Enqueue(commands, PASS_OPAQUE, transform, variantFor);
+            }
+          });
+    }
+
+    sceneTimer.begin();
+    if (deferredShading) {
+      gbuffer.resize(framebufferWidth, framebufferHeight);
+      gbuffer.bindForGeometry();
+    }
+
+    // Предварительный проход глубины: проход цвета затем закрашивает только
+    // видимые фрагменты (GL_EQUAL, без записи глубины)
+    if (depthPrepass) {
+      depthShader.use();
+      glState.colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      if (drawMode == DRAW_QUEUE)
+        renderQueue.submit(PASS_DEPTH);
+      else
+        drawBackpacks(depthShader, true);
+      glState.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+      glState.depthFunc(GL_EQUAL);
+      glState.depthMask(GL_FALSE);
+    }
+
+    // Проход цвета: по варианту шейдера на каждый набор карт материала
+    shadedFragments.begin();
+    if (drawMode == DRAW_QUEUE) {
+      renderQueue.submit(PASS_OPAQUE);
+      queueStateChanges = renderQueue.takeStateChanges();
+    } else {
+      for (std::uint32_t material : ourModel.materials()) {
+        Shader &backpackShader = backpackShaders.get(sceneFeatures | material);
+        backpackShader.use();
+        drawBackpacks(backpackShader, false, material);
+      }
+    }
+    shadedFragments.end();
+
+    if (depthPrepass) {
+      glState.depthFunc(GL_LESS);
+      glState.depthMask(GL_TRUE);
+    }
+
+    // Отложенное освещение: проход освещения
+    if (deferredShading) {
+      Shader &deferredShader = deferredShaders.get(sceneFeatures);
+      deferredShader.use();
+      deferredShader.setMat4("inverseViewProj",
+                             glm::inverse(projection * view));
+      gbuffer.drawLighting();
+    }
+    sceneTimer.end();
+
     // Источники света
     // ---------------
     // Привязка шейдера
     lampShader.use();
-    // Прикрепление VAO
-    glBindVertexArray(lampVAO);
-
-    // Матрица вида
-    lampShader.setMat4("view", view);
-    // Матрица проекции
-    lampShader.setMat4("projection", projection);
 
     for (unsigned int i = 0; i < nrLamps; i++) {
       // Матрица модели
@@ -392,79 +766,7 @@ int main() {
       lampShader.setVec3("lightColor", lamp[i].color);
 
       // Отрисовка примитивов
-      glDrawArrays(GL_TRIANGLES, 0, 36);
-    }
-
-    // Рюкзак
-    // ------
-    // Привязка шейдера
-    objShader.use();
-    // Матрица вида
-    objShader.setMat4("view", view);
-    // Матрица проекции
-    objShader.setMat4("projection", projection);
-
-    // Применение позиции камеры
-    objShader.setVec3("viewPos", camera.Position);
-
-    /* Применение настроек источников света */
-    // Направленный свет
-    objShader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
-    objShader.setVec3("dirLight.ambient", dirAmbient);
-    objShader.setVec3("dirLight.diffuse", dirDiffuse);
-    objShader.setVec3("dirLight.specular", dirSpecular);
-
-    // Точечный свет
-    for (unsigned int i = 0; i < nrLamps; i++) {
-      objShader.setVec3("pointLights[" + std::to_string(i) + "].position",
-                        lamp[i].position);
-      objShader.setFloat("pointLights[" + std::to_string(i) + "].linear",
-                         lamp[i].linear);
-      objShader.setFloat("pointLights[" + std::to_string(i) + "].quadratic",
-                         lamp[i].quadratic);
-      objShader.setVec3("pointLights[" + std::to_string(i) + "].diffuse",
-                        lamp[i].color * lamp[i].diff);
-      objShader.setVec3("pointLights[" + std::to_string(i) + "].ambient",
-                        lamp[i].color * lamp[i].diff * lamp[i].amb);
-      objShader.setVec3("pointLights[" + std::to_string(i) + "].specular",
-                        lamp[i].color * lamp[i].spec);
-    }
-
-    // Фонарик
-    objShader.setVec3("spotLight.position", camera.Position);
-    objShader.setVec3("spotLight.direction", camera.Front);
-    objShader.setFloat("spotLight.cutOff", spotCutOff);
-    objShader.setFloat("spotLight.outerCutOff", spotOuterCutOff);
-    objShader.setVec3("spotLight.ambient", spotAmbient);
-    objShader.setVec3("spotLight.diffuse", spotDiffuse);
-    objShader.setVec3("spotLight.specular", spotSpecular);
-    objShader.setFloat("spotLight.linear", spotLinear);
-    objShader.setFloat("spotLight.quadratic", spotQuadratic);
-
-    glm::vec3 modelPositions[] = {
-        glm::vec3(0.0f, 0.0f, 0.0f),    glm::vec3(2.0f, 5.0f, -15.0f),
-        glm::vec3(-1.5f, -2.2f, -2.5f), glm::vec3(-3.8f, -2.0f, -12.3f),
-        glm::vec3(2.4f, -0.4f, -3.5f),  glm::vec3(-1.7f, 3.0f, -7.5f),
-        glm::vec3(1.3f, -2.0f, -2.5f),  glm::vec3(1.5f, 2.0f, -2.5f),
-        glm::vec3(1.5f, 0.2f, -1.5f),   glm::vec3(-1.3f, 1.0f, -1.5f),
-    };
-    for (unsigned long i = 0; i < sizeof(modelPositions) / sizeof(glm::vec3);
-         i++) {
-      // Матрица модели
-      model = glm::mat4(1.0f);
-      model = glm::translate(model, modelPositions[i]);
-      model = glm::rotate(model,
-                          glm::radians(20.f * (float)(i + 1) * (float)gameTime *
-                                       (float)(pow(-1, i))),
-                          glm::vec3(1.f, 0.3f, 0.5f));
-      model = glm::scale(model, glm::vec3(0.3f));
-      objShader.setMat4("model", model);
-
-      // Применение матрицы нормали
-      objShader.setMat3("normalMatrix", glm::transpose(glm::inverse(model)));
-
-      // Отрисовка объектов
-      ourModel.Draw(objShader);
+      lampMesh.Draw(lampShader);
     }
 
     // Окно ImGui
@@ -524,6 +826,72 @@ int main() {
             ImGui::EndTabItem();
           }
         }
+        // Способ отрисовки
+        if (ImGui::BeginTabItem("Rendering")) {
+          ImGui::Combo("Draw mode", &drawMode, drawModeNames,
+                       IM_ARRAYSIZE(drawModeNames));
+          ImGui::SliderInt("Backpacks", &backpackCount, 1, 100000, "%d",
+                           ImGuiSliderFlags_Logarithmic);
+          std::size_t meshCount = ourModel.meshes().size();
+          std::size_t drawCalls = drawMode == DRAW_PER_MESH
+                                      ? meshCount * std::size_t(backpackCount)
+                                  : drawMode == DRAW_INDIRECT
+                                      ? sceneDraws.batchCount()
+                                  : drawMode == DRAW_QUEUE
+                                      ? renderQueue.batchCount()
+                                      : meshCount;
+          ImGui::Text("Draw calls: %zu", drawCalls);
+          if (drawMode == DRAW_QUEUE)
+            ImGui::Text("Queue: %zu commands (%zu culled) in %zu buffers, "
+                        "%zu program/texture changes",
+                        renderQueue.size(), renderQueue.culled(),
+                        renderQueue.bufferCount(), queueStateChanges);
+          if (ImGui::Checkbox("Deferred shading", &deferredShading))
+            sceneTimer.reset();
+          if (ImGui::Checkbox("Depth prepass", &depthPrepass)) {
+            sceneTimer.reset();
+            shadedFragments.reset();
+          }
+          ImGui::Text("Shaded fragments: %.0f", shadedFragments.value());
+          ImGui::Text("Overdraw: %.2f fragments per pixel",
+                      shadedFragments.value() /
+                          (double(framebufferWidth) *
+                           double(framebufferHeight)));
+          ImGui::Text("Backpacks pass: %.3f ms", sceneTimer.milliseconds());
+          ImGui::Text("GL state calls: %llu issued, %llu skipped",
+                      (unsigned long long)glState.frameIssued(),
+                      (unsigned long long)glState.frameSkipped());
+          ImGui::Text("Shader variants: %zu (%zu compiling)",
+                      objShaders.size() + gbufferShaders.size() +
+                          deferredShaders.size(),
+                      objShaders.pending() + gbufferShaders.pending() +
+                          deferredShaders.pending());
+          ImGui::EndTabItem();
+        }
+        // Кластерное освещение
+        if (ImGui::BeginTabItem("Clustered lights")) {
+          if (ImGui::Checkbox("Clustered", &clusteredLighting))
+            sceneTimer.reset();
+          if (ImGui::SliderInt("Extra point lights", &extraLightCount, 0,
+                               10000))
+            sceneTimer.reset();
+          ImGui::Text("Point lights: %zu", lights.points.size());
+          ImGui::Text("Cluster pass: %.3f ms", clusterTimer.milliseconds());
+          ImGui::Text("Backpacks pass: %.3f ms", sceneTimer.milliseconds());
+          ImGui::EndTabItem();
+        }
+        // Замер прохода глубины
+        if (ImGui::BeginTabItem("Depth pass")) {
+          if (ImGui::Checkbox("Benchmark", &depthBenchmark)) {
+            interleavedTimer.reset();
+            splitTimer.reset();
+          }
+          ImGui::SliderInt("Repeats", &depthBenchmarkRepeats, 1, 64);
+          ImGui::Text("Interleaved stream: %.3f ms",
+                      interleavedTimer.milliseconds());
+          ImGui::Text("Position stream: %.3f ms", splitTimer.milliseconds());
+          ImGui::EndTabItem();
+        }
       }
       ImGui::EndTabBar();
 
@@ -541,7 +909,10 @@ int main() {
       //---------------
       ImGui::Render();
       ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+      // Бэкенд ImGui меняет состояние OpenGL в обход кеша
+      glState.invalidate();
     }
+    glState.endFrame();
 
     // Проверка и вызов событий
     // ------------------------
@@ -559,10 +930,35 @@ int main() {
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
-  // Удаление VAO
-  glDeleteVertexArrays(1, &lampVAO);
-  // Удаление VBO
-  glDeleteBuffers(1, &cubeVBO);
+  // Выгрузка ассетов и остановка загрузки текстур
+  AssetRegistry::instance().shutdown();
+  TextureStreamer::instance().shutdown();
+  // Удаление меша источника света
+  lampMesh.release();
+  // Удаление запросов таймеров
+  interleavedTimer.release();
+  splitTimer.release();
+  clusterTimer.release();
+  sceneTimer.release();
+  shadedFragments.release();
+  // Удаление буферов непрямой отрисовки
+  sceneDraws.release();
+  renderQueue.release();
+  backpackInstances.release();
+  // Удаление буферов источников света
+  lights.release();
+  clusters.release();
+  gbuffer.release();
+  // Удаление вариантов шейдеров
+  objShaders.release();
+  gbufferShaders.release();
+  deferredShaders.release();
+  // Удаление буфера данных кадра
+  frameUniforms.release();
+  // Удаление буферов геометрии
+  GeometryHeap::instance().shutdown();
+  // Удаление буфера материалов
+  MaterialTable::instance().shutdown();
   // Освобождение ресурсов GLFW
   glfwTerminate();
 
@@ -663,10 +1059,10 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action,
   // Polygon mode
   if (key == GLFW_KEY_L && action == GLFW_PRESS) {
     if (l_flag) {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+      GLState::instance().polygonMode(GL_FRONT_AND_BACK, GL_FILL);
       l_flag = 0;
     } else {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+      GLState::instance().polygonMode(GL_FRONT_AND_BACK, GL_LINE);
       l_flag = 1;
     }
   }
@@ -0,0 +1,145 @@
+// Проверка блочного сжатия без контекста OpenGL
+// ---------------------------------------------
+// Синтетические изображения сжимаются кодировщиками BlockCompression.h,
+// распаковываются эталонными декодерами, и качество каждого формата
+// сравнивается с нижней границей PSNR. Код возврата 1, если хотя бы одна
+// проверка не прошла.
+
+// Остальные библиотеки
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Остальные заголовочные файлы
+#include "LearnOpenGL/BlockCompression.h" // Блочное сжатие текстур
+
+using namespace BlockCompression;
+
+// Изображение, заполненное функцией пикселя fill(x, y, rgba)
+using PixelFn = std::function<void(int, int, std::uint8_t *)>;
+static Image makeImage(int width, int height, const PixelFn &fill) {
+  Image image;
+  image.width = width;
+  image.height = height;
+  image.pixels.resize(static_cast<std::size_t>(width) *
+                      static_cast<std::size_t>(height) * 4);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      fill(x, y,
+           &image.pixels[(static_cast<std::size_t>(y) * std::size_t(width) +
+                          std::size_t(x)) *
+                         4]);
+  return image;
+}
+
+static std::uint8_t toByte(double value) {
+  return static_cast<std::uint8_t>(
+      std::lround(std::clamp(value, 0.0, 1.0) * 255.0));
+}
+
+// Плавные градиенты по всем каналам (размер не кратен блоку)
+static Image gradientImage() {
+  return makeImage(61, 35, [](int x, int y, std::uint8_t *pixel) {
+    pixel[0] = toByte(x / 60.0);
+    pixel[1] = toByte(y / 34.0);
+    pixel[2] = toByte((x + y) / 95.0);
+    pixel[3] = toByte(1.0 - x / 60.0);
+  });
+}
+
+// Синусоидальная карта нормалей в каналах R и G
+static Image normalImage() {
+  return makeImage(64, 64, [](int x, int y, std::uint8_t *pixel) {
+    double nx = 0.5 * std::sin(x * 0.2), ny = 0.5 * std::cos(y * 0.15);
+    pixel[0] = toByte(nx * 0.5 + 0.5);
+    pixel[1] = toByte(ny * 0.5 + 0.5);
+    pixel[2] = toByte(std::sqrt(1.0 - nx * nx - ny * ny));
+    pixel[3] = 255;
+  });
+}
+
+// Белый шум (худший случай для блочного сжатия)
+static Image noiseImage() {
+  std::mt19937 random(12345);
+  return makeImage(32, 32, [&](int, int, std::uint8_t *pixel) {
+    for (int c = 0; c < 4; c++)
+      pixel[c] = static_cast<std::uint8_t>(random() >> 24);
+  });
+}
+
+// Изображение одного цвета (сжимается почти без потерь)
+static Image flatImage() {
+  return makeImage(16, 16, [](int, int, std::uint8_t *pixel) {
+    pixel[0] = 200, pixel[1] = 120, pixel[2] = 40, pixel[3] = 180;
+  });
+}
+
+static const char *formatName(Format format) {
+  switch (format) {
+  case Format::BC1:
+    return "BC1";
+  case Format::BC3:
+    return "BC3";
+  case Format::BC4:
+    return "BC4";
+  case Format::BC5:
+    return "BC5";
+  }
+  return "?";
+}
+
+int main() {
+  struct Case {
+    const char *name;
+    Image image;
+    Format format;
+    double minPsnr;
+  };
+  // Границы взяты с запасом ниже текущих результатов кодировщиков
+  std::vector<Case> cases = {
+      {"gradient", gradientImage(), Format::BC1, 34.0},
+      {"gradient", gradientImage(), Format::BC3, 35.0},
+      {"gradient", gradientImage(), Format::BC4, 50.0},
+      {"gradient", gradientImage(), Format::BC5, 48.0},
+      {"normal", normalImage(), Format::BC1, 32.0},
+      {"normal", normalImage(), Format::BC5, 46.0},
+      {"noise", noiseImage(), Format::BC1, 12.0},
+      {"noise", noiseImage(), Format::BC3, 13.0},
+      {"noise", noiseImage(), Format::BC4, 26.0},
+      {"noise", noiseImage(), Format::BC5, 26.0},
+      {"flat", flatImage(), Format::BC1, 42.0},
+      {"flat", flatImage(), Format::BC3, 42.0},
+      {"flat", flatImage(), Format::BC4, 90.0},
+      {"flat", flatImage(), Format::BC5, 90.0},
+  };
+
+  int failures = 0;
+  for (const Case &test : cases) {
+    std::vector<std::uint8_t> data = encode(test.image, test.format);
+    std::string label =
+        std::string(test.name) + "::" + formatName(test.format);
+    if (data.size() !=
+        levelSize(test.format, test.image.width, test.image.height)) {
+      std::cout << "ERROR::BLOCK_COMPRESSION_CHECK::WRONG_SIZE::" << label
+                << std::endl;
+      failures++;
+      continue;
+    }
+    Image decoded = decode(data.data(), test.image.width, test.image.height,
+                           test.format);
+    double quality = psnr(test.image, decoded, test.format);
+    bool passed = quality >= test.minPsnr;
+    std::cout << (passed ? "INFO" : "ERROR")
+              << "::BLOCK_COMPRESSION_CHECK::" << label << ": " << quality
+              << " dB (min " << test.minPsnr << ")" << std::endl;
+    if (!passed)
+      failures++;
+  }
+  return failures == 0 ? 0 : 1;
+}